@@ -0,0 +1,277 @@
+#include "../include/Board.h"
+#include "../include/Engine.h"
+#include "../include/MovePicker.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Дебют, миттельшпиль, позиции perft-набора с рокировками, взятием на
+// проходе и превращениями, пешечный эндшпиль
+const char *const BENCH_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+};
+
+struct BenchOptions {
+    int repetitions = 50;  // замеров на каждую операцию
+    int batch = 1000;      // вызовов в одном замере
+    int depth = 7;         // глубина поиска для findBestMove и сигнатуры
+    bool json = false;
+    bool signatureOnly = false;
+};
+
+struct BenchResult {
+    std::string name;
+    double medianNs = 0; // на один вызов
+    double p99Ns = 0;
+};
+
+struct SearchBench {
+    uint64_t nodes = 0;  // сумма по позициям - сигнатура поиска
+    double medianMs = 0; // на весь набор позиций
+    double p99Ms = 0;
+};
+
+// Результаты складываются сюда, чтобы компилятор не выбросил вызовы
+volatile uint64_t sink = 0;
+
+double percentile(std::vector<double> samples, double fraction)
+{
+    std::sort(samples.begin(), samples.end());
+    const size_t index =
+        static_cast<size_t>(fraction * (samples.size() - 1) + 0.5);
+    return samples[index];
+}
+
+// Прогрев одним замером, затем repetitions замеров по batch вызовов;
+// call получает номер вызова и сам выбирает позицию
+template <typename Call>
+BenchResult
+measure(const std::string &name, const BenchOptions &options, Call &&call)
+{
+    for (int i = 0; i < options.batch; ++i) {
+        call(i);
+    }
+
+    std::vector<double> samples;
+    for (int r = 0; r < options.repetitions; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < options.batch; ++i) {
+            call(i);
+        }
+        const double ns = std::chrono::duration<double, std::nano>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+        samples.push_back(ns / options.batch);
+    }
+    return {name, percentile(samples, 0.5), percentile(samples, 0.99)};
+}
+
+// Поиск на фиксированную глубину в одном потоке с чистой таблицей
+// детерминирован, поэтому число узлов меняется только вместе с поиском
+SearchBench benchSearch(const std::vector<Board> &boards,
+                        const BenchOptions &options,
+                        bool timed)
+{
+    SearchBench result;
+    ChessEngine engine;
+    SearchLimits limits;
+    limits.maxDepth = options.depth;
+    std::vector<double> samples;
+    const int passes = timed ? std::max(1, options.repetitions / 10) : 1;
+    for (int pass = 0; pass < passes; ++pass) {
+        uint64_t nodes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (const Board &position : boards) {
+            Board board = position;
+            engine.clearHash();
+            const Move move = engine.findBestMove(board, limits);
+            sink = sink + move.from();
+            nodes += engine.getStats().nodes;
+        }
+        samples.push_back(std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - start)
+                              .count());
+        if (pass > 0 && nodes != result.nodes) {
+            throw std::runtime_error(
+                "число узлов поиска меняется от прогона к прогону");
+        }
+        result.nodes = nodes;
+    }
+    result.medianMs = percentile(samples, 0.5);
+    result.p99Ms = percentile(samples, 0.99);
+    return result;
+}
+
+std::vector<BenchResult> benchHotPaths(std::vector<Board> boards,
+                                       const BenchOptions &options)
+{
+    const int count = static_cast<int>(boards.size());
+    std::vector<MoveList> moves;
+    for (const Board &board : boards) {
+        moves.push_back(board.generateAllMoves(board.isWhiteToMove()));
+    }
+    ChessEngine engine;
+    static int history[2][64][64] = {};
+
+    std::vector<BenchResult> results;
+    results.push_back(measure("generateAllMoves", options, [&](int i) {
+        const Board &board = boards[i % count];
+        sink = sink + board.generateAllMoves(board.isWhiteToMove()).size();
+    }));
+    results.push_back(measure("makeMove", options, [&](int i) {
+        // В замер входит копирование доски: makeMove не умеет откатывать ход
+        const MoveList &list = moves[i % count];
+        Board board = boards[i % count];
+        sink = sink + board.makeMove(list[(i / count) % list.size()]);
+    }));
+    results.push_back(measure("doMove+undoMove", options, [&](int i) {
+        const MoveList &list = moves[i % count];
+        const Move &move = list[(i / count) % list.size()];
+        Board &board = boards[i % count];
+        UndoInfo undo;
+        board.doMove(move, undo);
+        board.undoMove(move, undo);
+        sink = sink + board.getHash();
+    }));
+    results.push_back(measure("isSquareUnderAttack", options, [&](int i) {
+        const int square = i % 64;
+        sink = sink + boards[i % count].isSquareUnderAttack(
+                          squareX(square), squareY(square), (i & 64) != 0);
+    }));
+    results.push_back(measure("isCheckmate", options, [&](int i) {
+        const Board &board = boards[i % count];
+        sink = sink + board.isCheckmate(board.isWhiteToMove());
+    }));
+    results.push_back(measure("evaluateBoard", options, [&](int i) {
+        sink = sink + engine.evaluateBoard(boards[i % count]);
+    }));
+    results.push_back(measure("MovePicker", options, [&](int i) {
+        // Полный перебор сборщика: генерация, SEE взятий, сортировка тихих
+        MovePicker picker(
+            boards[i % count], Move(), nullptr, Move(), history);
+        for (Move move = picker.next(); move.isValid(); move = picker.next()) {
+            sink = sink + move.to();
+        }
+    }));
+    return results;
+}
+
+uint64_t callsPerSecond(const BenchResult &result)
+{
+    return static_cast<uint64_t>(1e9 / result.medianNs);
+}
+
+uint64_t nodesPerSecond(const SearchBench &search)
+{
+    return static_cast<uint64_t>(search.nodes * 1000 / search.medianMs);
+}
+
+void printText(const std::vector<BenchResult> &results,
+               const SearchBench &search,
+               const BenchOptions &options,
+               std::ostream &out)
+{
+    out << std::fixed << std::setprecision(1);
+    out << std::left << std::setw(22) << "Benchmark" << std::right
+        << std::setw(12) << "median ns" << std::setw(12) << "p99 ns"
+        << std::setw(14) << "calls/s" << "\n";
+    for (const BenchResult &result : results) {
+        out << std::left << std::setw(22) << result.name << std::right
+            << std::setw(12) << result.medianNs << std::setw(12)
+            << result.p99Ns << std::setw(14) << callsPerSecond(result)
+            << "\n";
+    }
+
+    out << "\nfindBestMove depth " << options.depth << "\n";
+    out << "Nodes: " << search.nodes << "\n";
+    out << "Time: " << search.medianMs << " ms (p99 " << search.p99Ms
+        << " ms)\n";
+    out << "NPS: " << nodesPerSecond(search) << "\n";
+    out << "Bench signature: " << search.nodes << "\n";
+}
+
+void printJson(const std::vector<BenchResult> &results,
+               const SearchBench &search,
+               const BenchOptions &options,
+               std::ostream &out)
+{
+    out << std::fixed << std::setprecision(1);
+    out << "{\"benchmarks\":[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &result = results[i];
+        out << (i > 0 ? "," : "") << "{\"name\":\"" << result.name
+            << "\",\"median_ns\":" << result.medianNs
+            << ",\"p99_ns\":" << result.p99Ns
+            << ",\"calls_per_sec\":" << callsPerSecond(result) << "}";
+    }
+    out << "],\"search\":{\"depth\":" << options.depth
+        << ",\"nodes\":" << search.nodes
+        << ",\"median_ms\":" << search.medianMs
+        << ",\"p99_ms\":" << search.p99Ms
+        << ",\"nps\":" << nodesPerSecond(search)
+        << "},\"signature\":" << search.nodes << "}\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // chessbot-bench [--reps <N>] [--batch <N>] [--depth <N>] [--json]
+    //                [--signature]
+    BenchOptions options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--reps" && i + 1 < argc) {
+                options.repetitions = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--batch" && i + 1 < argc) {
+                options.batch = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--depth" && i + 1 < argc) {
+                options.depth = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--json") {
+                options.json = true;
+            } else if (arg == "--signature") {
+                options.signatureOnly = true;
+            } else {
+                throw std::invalid_argument("неизвестный параметр " + arg);
+            }
+        }
+
+        std::vector<Board> boards;
+        for (const char *fen : BENCH_POSITIONS) {
+            boards.push_back(Board::fromFEN(fen));
+        }
+
+        // Сигнатура - только число узлов, без замеров времени
+        if (options.signatureOnly) {
+            std::cout << benchSearch(boards, options, false).nodes << "\n";
+            return 0;
+        }
+
+        const std::vector<BenchResult> results = benchHotPaths(boards, options);
+        const SearchBench search = benchSearch(boards, options, true);
+        if (options.json) {
+            printJson(results, search, options, std::cout);
+        } else {
+            printText(results, search, options, std::cout);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Ошибка: " << e.what() << "\n"
+                  << "Использование: chessbot-bench [--reps <N>] [--batch <N>] "
+                     "[--depth <N>] [--json] [--signature]\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(NO_PEXT)
+#define HAS_PEXT 1
+#endif
+
+#if defined(HAS_PEXT) && defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Клетка кодируется как x * 8 + y, то есть board[x][y]: a8 = 0, h1 = 63.
+using Bitboard = uint64_t;
+
+enum Color : int { WHITE = 0, BLACK = 1 };
+
+enum PieceType : int {
+    PT_PAWN = 0,
+    PT_KNIGHT,
+    PT_BISHOP,
+    PT_ROOK,
+    PT_QUEEN,
+    PT_KING,
+    PT_NONE
+};
+
+constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H = FILE_A << 7;
+constexpr Bitboard RANK_8 = 0xFFULL;
+constexpr Bitboard RANK_1 = RANK_8 << 56;
+
+constexpr int makeSquare(int x, int y) { return x * 8 + y; }
+constexpr int squareX(int sq) { return sq >> 3; }
+constexpr int squareY(int sq) { return sq & 7; }
+constexpr Bitboard squareBB(int sq) { return 1ULL << sq; }
+
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int msb(Bitboard b) { return 63 - __builtin_clzll(b); }
+
+inline int popLsb(Bitboard &b)
+{
+    const int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+PieceType pieceTypeOf(char piece);
+char pieceChar(Color color, PieceType type);
+
+extern Bitboard PawnAttacks[2][64];
+extern Bitboard KnightAttacks[64];
+extern Bitboard KingAttacks[64];
+extern Bitboard BetweenBB[64][64]; // клетки строго между двумя на одной линии
+extern Bitboard LineBB[64][64];    // вся линия через две клетки
+
+// Таблица атак дальнобойной фигуры с одной клетки. Индекс - либо magic-
+// умножение, либо PEXT маски (выбирается при запуске по поддержке BMI2)
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *attacks;
+    int shift;
+};
+
+extern Magic RookMagics[64];
+extern Magic BishopMagics[64];
+extern bool UsePext;
+
+void initBitboards();
+
+#ifdef HAS_PEXT
+#ifdef __BMI2__
+inline uint64_t pext(Bitboard b, Bitboard mask) { return _pext_u64(b, mask); }
+#else
+uint64_t pext(Bitboard b, Bitboard mask);
+#endif
+#endif
+
+inline unsigned magicIndex(const Magic &m, Bitboard occupied)
+{
+#ifdef HAS_PEXT
+    if (UsePext) {
+        return static_cast<unsigned>(pext(occupied, m.mask));
+    }
+#endif
+    return static_cast<unsigned>(((occupied & m.mask) * m.magic) >> m.shift);
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied)
+{
+    const Magic &m = RookMagics[sq];
+    return m.attacks[magicIndex(m, occupied)];
+}
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied)
+{
+    const Magic &m = BishopMagics[sq];
+    return m.attacks[magicIndex(m, occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied)
+{
+    return rookAttacks(sq, occupied) | bishopAttacks(sq, occupied);
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "Bitboard.h"
 #include <vector>
 #include <string>
 #include <utility>
@@ -23,63 +24,189 @@ enum Piece : char {
     BLACK_KING = 'k'
 };
 
+// Ход упакован в 16 бит: клетка откуда (6), клетка куда (6) и флаги (4)
 struct Move {
 
-    int fromX, fromY, toX, toY;
+    enum Flag : uint16_t {
+        QUIET = 0,
+        DOUBLE_PUSH = 1,
+        KING_CASTLE = 2,
+        QUEEN_CASTLE = 3,
+        CAPTURE = 4,
+        EN_PASSANT = 5,
+        PROMOTION = 8,  // + (фигура - PT_KNIGHT)
+        PROMOTION_CAPTURE = 12
+    };
+
+    uint16_t data;
+
+    Move() : data(0) {}
+    Move(int from, int to, int flags)
+        : data(static_cast<uint16_t>(from | (to << 6) | (flags << 12)))
+    {
+    }
+    Move(int frX, int frY, int tX, int tY);
+
+    int from() const { return data & 0x3F; }
+    int to() const { return (data >> 6) & 0x3F; }
+    int flags() const { return data >> 12; }
+    int fromX() const { return squareX(from()); }
+    int fromY() const { return squareY(from()); }
+    int toX() const { return squareX(to()); }
+    int toY() const { return squareY(to()); }
+
+    bool isCapture() const { return (flags() & CAPTURE) != 0; }
+    bool isPromotion() const { return (flags() & PROMOTION) != 0; }
+    bool isCastle() const { return flags() == KING_CASTLE || flags() == QUEEN_CASTLE; }
+    PieceType promotionType() const
+    {
+        return isPromotion() ? static_cast<PieceType>(PT_KNIGHT + (flags() & 3)) : PT_NONE;
+    }
 
-    Move(int frX = -1, int frY = -1, int tX = -1, int tY = -1);
     bool isValid() const;
+    bool sameSquares(const Move& other) const
+    {
+        return (data & 0xFFF) == (other.data & 0xFFF);
+    }
     static Move fromChessNotation(const std::string& from, const std::string& to);
     std::string toChessNotation() const;
+    std::string toUci() const; // "e2e4", "e7e8q"
 
-    bool operator==(const Move& other) const {
-        return fromX == other.fromX && fromY == other.fromY &&
-               toX == other.toX && toY == other.toY;
-    }
+    bool operator==(const Move& other) const { return data == other.data; }
+    bool operator!=(const Move& other) const { return data != other.data; }
 
     friend std::ostream& operator<<(std::ostream& os, const Move& move) {
-        
-                return os << char('a' + move.fromY) << (8 - move.fromX) 
-                         << " " << char('a' + move.toY) << (8 - move.toX);
-        
+        return os << move.toChessNotation();
     }
 };
 
+// Список ходов фиксированной ёмкости, живёт на стеке
+class MoveList {
+public:
+    static constexpr int MAX_MOVES = 256;
+
+    void add(Move move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](int i) { return moves[i]; }
+    const Move& operator[](int i) const { return moves[i]; }
+
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+
+private:
+    Move moves[MAX_MOVES];
+    int count = 0;
+};
+
+struct UndoInfo {
+    char movedPiece;
+    char capturedPiece;
+    bool castlingRights[2][2];
+    bool kingHasMoved[2];
+    int epSquare;
+    bool whiteToMove;
+    int halfmoveClock;
+    uint64_t hashKey;
+};
+
+// Легальные ходы позиции и всё, что из них следует: шах, мат, пат.
+// Ходы генерируются один раз и дальше используются для перебора
+struct NodeStatus {
+    MoveList moves;
+    bool inCheck = false;
+
+    bool isCheckmate() const { return inCheck && moves.empty(); }
+    bool isStalemate() const { return !inCheck && moves.empty(); }
+};
+
+// Какие ходы генерировать. Взятия включают превращения, тихие - рокировки
+enum GenType { GEN_ALL, GEN_CAPTURES, GEN_QUIETS };
+
 class Board {
 private:
-    void generatePawnMoves(int x, int y, bool isWhite, std::vector<Move>& moves) const;
-    void generateKnightMoves(int x, int y, bool isWhite, std::vector<Move>& moves) const;
-    void generateBishopMoves(int x, int y, bool isWhite, std::vector<Move>& moves) const;
-    void generateRookMoves(int x, int y, bool isWhite, std::vector<Move>& moves) const;
-    void generateQueenMoves(int x, int y, bool isWhite, std::vector<Move>& moves) const;
-    void generateKingMoves(int x, int y, bool isWhite, std::vector<Move>& moves) const;
+    void generatePawnMoves(int from, bool isWhite, Bitboard allowed, GenType type, MoveList& moves) const;
+    void generatePieceMoves(int from, Bitboard targets, MoveList& moves) const;
+    void generateKingMoves(int from, bool isWhite, Bitboard danger, bool inCheck, GenType type, MoveList& moves) const;
 
     bool isInBounds(int x, int y) const;
     bool isEmpty(int x, int y) const;
-    bool isEnemy(int x, int y, bool isWhite) const;
-    bool isAlly(int x, int y, bool isWhite) const;
+
+    Bitboard pieces[2][6];     // [white/black][тип фигуры]
+    Bitboard occupied[2];      // [white/black]
+    Bitboard occupiedAll;
+
+    void putPiece(int sq, char piece);
+    void removePiece(int sq);
+    void movePiece(int from, int to);
+    void syncBitboards();
+    bool isSquareAttacked(int sq, Color by) const;
+    Bitboard attackersTo(int sq, Bitboard occ) const;
+    Bitboard attackedSquares(Color by, Bitboard occ) const;
+    Bitboard pinnedPieces(Color color) const;
+    int kingSquare(Color color) const;
+    int castlingIndex() const;
 
     bool castlingRights[2][2]; // [white/black][kingside/queenside]
     bool kingHasMoved[2];      // [white/black]
+    int epSquare;              // клетка для взятия на проходе или -1
+    bool whiteToMove;
+    int halfmoveClock;         // полуходы без взятий и ходов пешек
+    int fullmoveNumber;        // номер хода, растёт после хода чёрных
+    uint64_t hashKey;          // Zobrist-ключ, обновляется в doMove/undoMove
+    int psqtMg;                // материал + таблицы фигура-поле, миттельшпиль
+    int psqtEg;                // то же для эндшпиля
+    int phase;                 // стадия партии, см. PhaseWeight
 
     bool hasKingMoved(bool isWhite) const;
-    bool canCastleKingside(bool isWhite) const;
-    bool canCastleQueenside(bool isWhite) const;
-    bool isPathClearForCastling(int y, int startX, int endX) const;
-    bool isSquareUnderAttack(int x, int y, bool byWhite) const;
-    bool canCastle(bool isWhite, bool kingside) const;
+    std::string sanBody(const Move& move) const;
 
 public:
     char board[8][8];
 
     Board();
+    static Board fromFEN(const std::string& fen);
+    std::string toFEN() const;
     void resetBoard();
     void print() const;
     bool makeMove(const Move& move);
+    void doMove(const Move& move, UndoInfo& undo);
+    void undoMove(const Move& move, const UndoInfo& undo);
+    void doNullMove(UndoInfo& undo);
+    void undoNullMove(const UndoInfo& undo);
     bool isWhite(int x, int y) const;
-    std::vector<Move> generateAllMoves(bool isWhite) const;
+    MoveList generateAllMoves(bool isWhite) const;
+    MoveList generateCaptures(bool isWhite) const; // взятия и превращения
+    void generateMoves(bool isWhite, GenType type, MoveList& moves, Bitboard fromMask = ~0ULL) const;
+    bool isLegal(const Move& move) const; // для стороны, чей ход
+    NodeStatus nodeStatus(bool isWhite) const;
+    int see(const Move& move) const;
+    Move findLegalMove(const Move& move, bool isWhiteTurn) const;
     bool isCheck(bool isWhite) const;
+    bool isSquareUnderAttack(int x, int y, bool byWhite) const;
     bool isStalemate(bool isWhite) const;
     bool isCheckmate(bool isWhite) const;
     bool isValidMove(const Move& move, bool isWhiteTurn) const;
+    std::string toSan(const Move& move) const;     // "Nbd7", "exd8=Q+"
+    Move parseSan(const std::string& text) const;  // SAN или UCI, иначе Move()
+
+    Bitboard getPieces(Color color, PieceType type) const { return pieces[color][type]; }
+    Bitboard getOccupancy(Color color) const { return occupied[color]; }
+    Bitboard getOccupancy() const { return occupiedAll; }
+
+    bool isWhiteToMove() const { return whiteToMove; }
+    int getCastlingRights() const { return castlingIndex(); } // бит color * 2 + side
+    int getEpSquare() const { return epSquare; }
+    int getHalfmoveClock() const { return halfmoveClock; }
+    int getFullmoveNumber() const { return fullmoveNumber; }
+    uint64_t getHash() const { return hashKey; }
+    uint64_t computeHash() const;
+
+    int getMgScore() const { return psqtMg; }
+    int getEgScore() const { return psqtEg; }
+    int getPhase() const { return phase; }
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "Board.h"
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct BookMove {
+    Move move;
+    uint16_t weight;
+};
+
+// Ключ позиции по схеме Polyglot: 781 случайное число на фигуры по полям,
+// права рокировки, вертикаль взятия на проходе и очередь белых
+uint64_t polyglotKey(const Board& board);
+
+// Сверка polyglotKey с ключами контрольных позиций из спецификации
+bool checkPolyglotKeys(std::ostream& out);
+
+// Дебютная книга в формате Polyglot: записи по 16 байт (ключ, ход, вес,
+// learn) в big-endian, отсортированные по ключу. Файл отображается в память
+// и не копируется, поэтому несколько процессов делят одну копию в кэше ОС
+class OpeningBook {
+public:
+    OpeningBook() = default;
+    ~OpeningBook();
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+    size_t size() const { return entryCount; }
+
+    // Легальные ходы книги для позиции, от большего веса к меньшему
+    std::vector<BookMove> probe(const Board& board) const;
+
+    // Ход, выбранный с вероятностью по весу, или самый весомый.
+    // Если позиции в книге нет - Move()
+    Move pickMove(const Board& board, bool weightedRandom);
+
+private:
+    const unsigned char* data = nullptr;
+    size_t mappedBytes = 0;
+    size_t entryCount = 0;
+    std::mt19937_64 rng{std::random_device{}()};
+
+    uint64_t keyAt(size_t index) const;
+};
+
+int bookCommand(int argc, char* argv[]);
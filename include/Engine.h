@@ -1,14 +1,161 @@
 #pragma once
 #include "Board.h"
+#include "Book.h"
+#include "SearchStats.h"
+#include "Tablebase.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
 #include <vector>
 #include <limits>
 
+// Ограничения поиска; 0 - без ограничения по этому параметру.
+// При ponder поиск идёт без ограничений до ponderHit() или stop(),
+// а время начинает считаться с момента ponderHit()
+struct SearchLimits {
+    int maxDepth = 64; // предел итеративного углубления
+    int64_t maxTimeMs = 0;
+    uint64_t maxNodes = 0;
+    bool ponder = false;
+};
+
+// Сведения о ходе поиска для внешнего интерфейса. После каждой итерации
+// заполнены все поля, в промежуточных отчётах раз в секунду pv пуст
+struct SearchInfo {
+    int depth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+    int hashfull = 0;
+    std::vector<Move> pv;
+};
+
+using InfoCallback = std::function<void(const SearchInfo&)>;
+
+// Отдельные техники отбора можно выключать, чтобы сравнивать их вклад
+struct SearchOptions {
+    bool pvs = true;      // поиск с нулевым окном для не первых ходов
+    bool nullMove = true; // пропуск хода с уменьшенной глубиной
+    bool lmr = true;      // сокращение глубины для поздних тихих ходов
+    bool futility = true; // отсечение тихих ходов у листьев
+};
+
+constexpr int MAX_PLY = 128;
+
+// Итог поиска: лучший ход, его оценка со стороны ходящего, глубина
+// последней завершённой итерации и главный вариант начиная с этого хода
+struct SearchResult {
+    Move bestMove;
+    int score = 0;
+    int depth = 0;
+    std::vector<Move> pv;
+};
+
+// Оценки в поиске - со стороны того, чей ход. Мат в n полуходов от корня
+// оценивается как MATE_SCORE - n
+constexpr int MATE_SCORE = 32000;
+constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY;
+constexpr int INF_SCORE = MATE_SCORE + 1;
+
+// Состояние одного потока поиска: своя копия доски, счётчики и статистика
+// для сортировки ходов. Таблица перестановок и флаг остановки общие
+struct alignas(64) SearchThread {
+    int id = 0;
+    Board board;
+    MoveList rootMoves;
+    SearchResult result;
+    int rootDepth = 0;
+    std::atomic<uint64_t> nodes{0};
+
+    Move pv[MAX_PLY][MAX_PLY];   // треугольная таблица главных вариантов
+    int pvLength[MAX_PLY];
+
+    Move moveStack[MAX_PLY];     // ход, сделанный на каждом ply
+    Move killers[MAX_PLY][2];    // тихие ходы, давшие отсечение на этом ply
+    int history[2][64][64];      // [сторона][откуда][куда]
+    Move counterMoves[64][64];   // ответ на ход соперника [откуда][куда]
+
+    SearchStats stats;
+
+    void clearHeuristics();
+};
+
 class ChessEngine {
 public:
+    explicit ChessEngine(size_t hashMegabytes = 16);
+    ~ChessEngine();
+
+    SearchResult search(Board& board, const SearchLimits& limits);
+
+    // Тот же поиск в фоновом потоке; результат забирает waitSearch()
+    void startSearch(const Board& board, const SearchLimits& limits);
+    SearchResult waitSearch();
+
     Move findBestMove(Board& board, bool isWhite, int depth);
+    Move findBestMove(Board& board, const SearchLimits& limits);
+    void setHashSize(size_t megabytes);
+    void clearHash();
+    void setThreads(int count);
+    void setOptions(const SearchOptions& searchOptions) { options = searchOptions; }
+    void setInfoCallback(InfoCallback callback) { infoCallback = std::move(callback); }
 
-private:
-    int minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer);
+    // Позиция из книги получает ход без поиска. Пустой путь отключает книгу
+    bool setBookFile(const std::string& path);
+    void setBookRandom(bool weightedRandom) { bookRandom = weightedRandom; }
+
+    // Таблицы эндшпиля из каталога; возвращает число загруженных
+    int setTablebasePath(const std::string& directory);
+
+    // Статистика последнего завершённого поиска
+    const SearchStats& getStats() const { return lastStats; }
+
+    // Статическая оценка позиции со стороны белых
     int evaluateBoard(const Board& board);
-    std::vector<Move> orderMoves(const Board& board, const std::vector<Move>& moves);
+
+    // Вызываются из другого потока, пока идёт search()
+    void stop();
+    void ponderHit();
+
+private:
+    TranspositionTable tt;
+    std::vector<std::unique_ptr<SearchThread>> threads;
+
+    SearchLimits limits;
+    SearchOptions options;
+    InfoCallback infoCallback;
+    int64_t nextReportMs = 0;
+    std::chrono::steady_clock::time_point searchStart;
+    std::atomic<int64_t> startTicks{0}; // steady_clock, отсчёт лимита времени
+    std::atomic<bool> stopped{false};
+    std::atomic<bool> pondering{false};
+
+    std::thread searchWorker;
+    Board asyncBoard;
+    SearchResult asyncResult;
+    SearchStats lastStats;
+    OpeningBook book;
+    bool bookRandom = true;
+    Tablebases tablebases;
+
+    void prepareSearch(const SearchLimits& limits);
+    SearchResult runSearch(Board& board);
+
+    void iterativeDeepening(SearchThread& thread);
+    int searchRoot(SearchThread& thread, int depth, int alpha, int beta, Move& bestMove);
+    void updatePv(SearchThread& thread, int ply, const Move& move);
+    bool probeRoot(Board& board, const MoveList& moves, SearchResult& result);
+    int64_t elapsedMs() const;
+    int64_t searchTimeMs() const;
+    uint64_t totalNodes() const;
+    bool checkLimits(SearchThread& thread);
+
+    int negamax(SearchThread& thread, int depth, int ply, int alpha, int beta, bool allowNull);
+    int quiescence(SearchThread& thread, int ply, int alpha, int beta);
+    int evaluate(const Board& board);
+    void updateQuietStats(SearchThread& thread, const Move& move, int depth, int ply,
+                          const Move* quietsTried, int quietCount);
 };
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include "Engine.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Позиция тестового набора: FEN без счётчиков и операции bm/am/id
+struct EpdEntry {
+    std::string fen;
+    std::string id;
+    std::vector<std::string> bestMoves;  // bm: решение - один из этих ходов
+    std::vector<std::string> avoidMoves; // am: ни один из этих ходов
+};
+
+struct EpdOptions {
+    SearchLimits limits;      // лимит на каждую позицию
+    int threads = 1;          // позиции решаются параллельно, по одной на поток
+    size_t hashMegabytes = 16; // таблица у каждого потока своя
+};
+
+struct EpdSummary {
+    int positions = 0;
+    int solved = 0;
+    uint64_t nodes = 0;
+    double seconds = 0;
+};
+
+EpdEntry parseEpdLine(const std::string& line);
+std::vector<EpdEntry> readEpd(std::istream& in);
+EpdSummary runEpd(const std::vector<EpdEntry>& entries, const EpdOptions& options, std::ostream& out);
+int epdCommand(int argc, char* argv[]);
@@ -0,0 +1,48 @@
+#pragma once
+#include "Engine.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Настройки одного участника матча
+struct EngineConfig {
+    std::string name;
+    SearchOptions options;
+    size_t hashMegabytes = 16;
+    int threads = 1;
+};
+
+struct MatchOptions {
+    EngineConfig engines[2];
+    SearchLimits limits;         // лимит на каждый ход
+    std::vector<std::string> openings; // FEN; каждая играется дважды со сменой цветов
+    int games = 100;
+    int concurrency = 1;         // партии идут параллельно, по одной на поток
+    int maxMoves = 200;          // после стольких ходов партия признаётся ничьей
+
+    // SPRT: H0 - разница elo0, H1 - elo1; alpha и beta - ошибки I и II рода
+    bool sprt = true;
+    double elo0 = 0;
+    double elo1 = 5;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+// Счёт с точки зрения первого участника
+struct MatchSummary {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    uint64_t nodes[2] = {};  // узлы и время поиска каждого участника
+    double seconds[2] = {};
+
+    int games() const { return wins + draws + losses; }
+    double score() const;
+    double elo() const;
+    double eloError() const; // половина 95% доверительного интервала
+    double llr(double elo0, double elo1) const;
+};
+
+EngineConfig parseEngineConfig(const std::string& spec); // бросает invalid_argument
+MatchSummary runMatch(const MatchOptions& options, std::ostream& out);
+int matchCommand(int argc, char* argv[]);
@@ -0,0 +1,46 @@
+#pragma once
+#include "Board.h"
+
+// Выдаёт ходы узла по стадиям: ход из таблицы, выгодные взятия, киллеры,
+// тихие ходы, проигрывающие взятия. Следующая стадия генерируется только
+// если до неё дошло дело, а внутри стадии лучший ход выбирается по одному
+class MovePicker {
+public:
+    MovePicker(const Board& board,
+               const Move& ttMove,
+               const Move* killers,
+               const Move& counterMove,
+               const int (*history)[64][64]);
+
+    Move next();
+
+private:
+    enum Stage {
+        STAGE_TT,
+        STAGE_GEN_CAPTURES,
+        STAGE_GOOD_CAPTURES,
+        STAGE_KILLERS,
+        STAGE_GEN_QUIETS,
+        STAGE_QUIETS,
+        STAGE_BAD_CAPTURES,
+        STAGE_DONE
+    };
+
+    const Board& board;
+    Move ttMove;
+    Move killers[2];
+    Move counterMove;
+    const int (*history)[64][64];
+
+    Stage stage = STAGE_TT;
+    MoveList moves;
+    int scores[MoveList::MAX_MOVES];
+    int current = 0;
+    MoveList badCaptures;
+    int badIndex = 0;
+    int killerIndex = 0;
+
+    void scoreCaptures();
+    void scoreQuiets();
+    Move pickBest();
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include "Board.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+struct PerftOptions {
+    int depth = 1;
+    bool divide = false;
+    size_t hashMegabytes = 0; // 0 - без кэша поддеревьев
+    int threads = 1;
+};
+
+// Кэш числа узлов поддерева по ключу позиции и глубине. Записи
+// защищены XOR-проверкой, поэтому таблицу можно делить между потоками
+class PerftHash {
+public:
+    explicit PerftHash(size_t megabytes);
+
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+    void store(uint64_t key, int depth, uint64_t nodes);
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;  // nodes << 8 | depth
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    size_t mask = 0;
+};
+
+uint64_t perft(Board& board, int depth, PerftHash* hash = nullptr);
+uint64_t runPerft(const Board& board, const PerftOptions& options, std::ostream& out);
+int perftCommand(int argc, char* argv[]);
@@ -0,0 +1,13 @@
+#pragma once
+#include "Bitboard.h"
+
+// Материал плюс бонус фигуры за клетку, в сантипешках со стороны белых:
+// фигуры чёрных входят со знаком минус
+extern int PsqtMg[2][6][64];
+extern int PsqtEg[2][6][64];
+
+// Вклад фигур в стадию партии: 24 - все фигуры на доске, 0 - голые короли
+constexpr int PhaseWeight[6] = {0, 1, 1, 2, 4, 0};
+constexpr int MAX_PHASE = 24;
+
+void initPsqt();
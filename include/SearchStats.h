@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Участки, время которых меряют таймеры при сборке с -DSEARCH_TIMERS
+enum SearchTimer : int {
+    TIMER_MOVEGEN = 0, // генерация ходов
+    TIMER_EVAL,        // статическая оценка
+    TIMER_ORDERING,    // оценка и выбор ходов при сортировке
+    TIMER_COUNT
+};
+
+// Итерация углубления: узлы и время - нарастающим итогом с начала поиска
+struct DepthStats {
+    int depth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+};
+
+// Статистика одного поиска. Каждый поток ведёт свои счётчики без
+// синхронизации, в конце поиска они складываются в одну структуру
+struct SearchStats {
+    uint64_t nodes = 0;
+    uint64_t qnodes = 0;           // из них узлов форсированного поиска
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+    uint64_t cutoffs = 0;          // отсечения по beta
+    uint64_t firstMoveCutoffs = 0; // из них на первом же ходе
+    uint64_t tbHits = 0;           // узлы, оценённые по таблицам эндшпиля
+    int64_t timeMs = 0;
+    int threads = 0;
+    uint64_t timerNs[TIMER_COUNT] = {};
+    std::vector<DepthStats> depths;
+
+    void clear() { *this = SearchStats(); }
+    void merge(const SearchStats& other);
+
+    uint64_t nps() const;
+    double branchingFactor() const;
+    double ttHitRate() const;
+    double firstMoveCutoffRate() const;
+    bool hasTimers() const;
+
+    void printText(std::ostream& out) const;
+    void printJson(std::ostream& out) const;
+};
+
+// Время, набранное таймерами текущего потока с последнего сброса
+void resetSearchTimers();
+void collectSearchTimers(SearchStats& stats);
+
+#ifdef SEARCH_TIMERS
+extern thread_local uint64_t SearchTimerNs[TIMER_COUNT];
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(SearchTimer timer)
+        : timer(timer), start(std::chrono::steady_clock::now())
+    {
+    }
+    ~ScopedTimer()
+    {
+        SearchTimerNs[timer] +=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    SearchTimer timer;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define SEARCH_TIMER(timer) ScopedTimer scopedTimer(timer)
+#else
+#define SEARCH_TIMER(timer) ((void)0)
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+#include "Board.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr int TB_MAX_PIECES = 4;
+
+// Позиция эндшпиля в виде списка фигур: 0 - белый король, 1 - чёрный,
+// дальше фигуры белых и чёрных в порядке сигнатуры таблицы
+struct TbPosition {
+    int count = 0;
+    int square[TB_MAX_PIECES];
+    PieceType type[TB_MAX_PIECES];
+    Color color[TB_MAX_PIECES];
+    bool whiteToMove = true;
+};
+
+// Сигнатура вида "KQvKR": фигуры сторон кроме королей, от ферзя к пешке
+struct TbMaterial {
+    std::vector<PieceType> white;
+    std::vector<PieceType> black;
+
+    static TbMaterial parse(const std::string& name); // бросает invalid_argument
+    std::string name() const;
+    bool hasPawns() const;
+    int pieceCount() const { return 2 + int(white.size() + black.size()); }
+    TbMaterial flipped() const { return {black, white}; }
+    bool isCanonical() const; // сильнейшая сторона записана белыми
+};
+
+// Результат со стороны ходящего. dtm - полуходы до мата при лучшей игре
+struct TbResult {
+    int wdl = 0; // 1 - выигрыш, 0 - ничья, -1 - проигрыш
+    int dtm = 0;
+};
+
+// Одна таблица: на позицию приходится bits бит, значение 0 - ничья,
+// иначе dtm + 1 (нечётный dtm - выигрыш ходящего, чётный - проигрыш)
+class Tablebase {
+public:
+    Tablebase(const TbMaterial& material, std::vector<uint64_t> packed, int bits);
+    Tablebase(const TbMaterial& material, const uint64_t* data, int bits,
+              void* mapping, size_t mappedBytes);
+    ~Tablebase();
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    const TbMaterial& getMaterial() const { return material; }
+    size_t size() const { return entries; }
+    TbResult probe(const TbPosition& position) const; // позиция в раскладке таблицы
+
+    static size_t entryCount(const TbMaterial& material);
+    static size_t index(const TbMaterial& material, const TbPosition& position);
+    static bool decode(const TbMaterial& material, size_t index, TbPosition& position);
+
+private:
+    TbMaterial material;
+    size_t entries = 0;
+    int bits = 0;
+    std::vector<uint64_t> owned;
+    const uint64_t* data = nullptr;
+    void* mapping = nullptr;
+    size_t mappedBytes = 0;
+};
+
+// Набор таблиц, найденных в каталоге или только что построенных
+class Tablebases {
+public:
+    int load(const std::string& directory); // число загруженных таблиц
+    void add(std::unique_ptr<Tablebase> table);
+    void clear()
+    {
+        tables.clear();
+        largest = 0;
+    }
+    bool empty() const { return tables.empty(); }
+    bool contains(const std::string& name) const { return tables.count(name) > 0; }
+    int maxPieces() const { return largest; } // 0, пока таблиц нет
+
+    // Позиция любой раскладки: цвета при необходимости меняются местами.
+    // Две фигуры (одни короли) - всегда ничья
+    bool probe(const TbPosition& position, TbResult& result) const;
+    bool probe(const Board& board, TbResult& result) const;
+
+private:
+    std::map<std::string, std::unique_ptr<Tablebase>> tables;
+    int largest = 0;
+};
+
+bool toTbPosition(const Board& board, TbPosition& position, TbMaterial& material);
+void writeTablebase(const std::string& path, const TbMaterial& material,
+                    const std::vector<uint64_t>& packed, int bits);
+int tbgenCommand(int argc, char* argv[]);
@@ -0,0 +1,58 @@
+#pragma once
+#include "Board.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum TTBound : uint8_t { TT_NONE = 0, TT_EXACT, TT_LOWER, TT_UPPER };
+
+struct TTEntry {
+    uint64_t key;
+    int32_t score;
+    Move bestMove;
+    int8_t depth;
+    uint8_t genBound; // поколение << 2 | тип оценки
+
+    TTBound bound() const { return static_cast<TTBound>(genBound & 3); }
+    uint8_t generation() const { return genBound >> 2; }
+};
+
+// Таблица общая для всех потоков поиска и работает без блокировок: запись
+// хранится как (key ^ data, data), и разорванная параллельной записью
+// ячейка просто не проходит проверку ключа при чтении
+class TranspositionTable {
+public:
+    static constexpr int BUCKET_SIZE = 4;
+
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    void resize(size_t megabytes);
+    void clear();
+    void newSearch();
+
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, int depth, int score, TTBound bound, const Move& bestMove);
+
+    int hashfull() const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    // 16 байт на запись: корзина занимает одну кэш-линию
+    struct alignas(64) Bucket {
+        Slot slots[BUCKET_SIZE];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount = 0;
+    size_t mask = 0;
+    uint8_t generation = 0;
+
+    static uint64_t pack(const TTEntry& entry);
+    static TTEntry unpack(uint64_t key, uint64_t data);
+    int age(const TTEntry& entry) const;
+};
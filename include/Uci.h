@@ -0,0 +1,7 @@
+#pragma once
+#include <iostream>
+
+// Режим UCI для графических оболочек и турнирных менеджеров: команды
+// читаются из in, ответы пишутся в out. Поиск идёт в отдельном потоке,
+// так что stop и ponderhit обрабатываются сразу
+int uciLoop(std::istream& in, std::ostream& out);
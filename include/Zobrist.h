@@ -0,0 +1,14 @@
+#pragma once
+#include "Bitboard.h"
+#include <cstdint>
+
+struct ZobristKeys {
+    uint64_t pieces[2][6][64]; // [white/black][тип фигуры][клетка]
+    uint64_t castling[16];     // по маске действующих прав рокировки
+    uint64_t epFile[8];
+    uint64_t side;             // ход чёрных
+};
+
+extern ZobristKeys Zobrist;
+
+void initZobrist();
@@ -0,0 +1,331 @@
+#include "../include/Bitboard.h"
+#include <cctype>
+#include <mutex>
+
+Bitboard PawnAttacks[2][64];
+Bitboard KnightAttacks[64];
+Bitboard KingAttacks[64];
+Bitboard BetweenBB[64][64];
+Bitboard LineBB[64][64];
+
+Magic RookMagics[64];
+Magic BishopMagics[64];
+bool UsePext = false;
+
+#if defined(HAS_PEXT) && !defined(__BMI2__)
+#include <immintrin.h>
+
+__attribute__((target("bmi2"))) uint64_t pext(Bitboard b, Bitboard mask)
+{
+    return _pext_u64(b, mask);
+}
+#endif
+
+namespace {
+
+// Лучи в восьми направлениях: первые четыре - ладейные, остальные - слоновые
+constexpr int rayDirections[8][2] = {
+    {-1, 0 },
+    {1,  0 },
+    {0,  -1},
+    {0,  1 },
+    {-1, -1},
+    {-1, 1 },
+    {1,  -1},
+    {1,  1 }
+};
+
+Bitboard Rays[8][64];
+
+Bitboard RookTable[0x19000];  // сумма 2^(биты маски) по всем клеткам
+Bitboard BishopTable[0x1480];
+
+Bitboard offsetsMask(int sq, const int (*offsets)[2], int count)
+{
+    Bitboard result = 0;
+    for (int i = 0; i < count; ++i) {
+        const int nx = squareX(sq) + offsets[i][0];
+        const int ny = squareY(sq) + offsets[i][1];
+        if (nx >= 0 && nx < 8 && ny >= 0 && ny < 8) {
+            result |= squareBB(makeSquare(nx, ny));
+        }
+    }
+    return result;
+}
+
+Bitboard rayAttacks(int dir, int sq, Bitboard occupied)
+{
+    const Bitboard ray = Rays[dir][sq];
+    const Bitboard blockers = ray & occupied;
+    if (!blockers) {
+        return ray;
+    }
+    // Направления с ростом индекса клетки упираются в младший бит
+    const bool increasing = rayDirections[dir][0] * 8 + rayDirections[dir][1] > 0;
+    const int blocker = increasing ? lsb(blockers) : msb(blockers);
+    return ray ^ Rays[dir][blocker];
+}
+
+Bitboard slidingAttacks(int sq, Bitboard occupied, bool rook)
+{
+    Bitboard result = 0;
+    for (int dir = rook ? 0 : 4; dir < (rook ? 4 : 8); ++dir) {
+        result |= rayAttacks(dir, sq, occupied);
+    }
+    return result;
+}
+
+// Маска релевантных блокеров: лучи без крайней клетки, она всё равно
+// атакована при любом заполнении
+Bitboard relevantMask(int sq, bool rook)
+{
+    Bitboard result = 0;
+    for (int dir = rook ? 0 : 4; dir < (rook ? 4 : 8); ++dir) {
+        Bitboard ray = Rays[dir][sq];
+        if (ray) {
+            const bool increasing =
+                rayDirections[dir][0] * 8 + rayDirections[dir][1] > 0;
+            ray &= ~squareBB(increasing ? msb(ray) : lsb(ray));
+        }
+        result |= ray;
+    }
+    return result;
+}
+
+// Заранее найденные magic-числа для нашей нумерации клеток (a8 = 0)
+constexpr Bitboard RookMagicNumbers[64] = {
+    0x008000908064C000ULL, 0x0040200040001000ULL, 0x0180100080A0010AULL,
+    0x8880041000800800ULL, 0x1200100201200804ULL, 0x0200020004011008ULL,
+    0x2180010000800600ULL, 0x0200005088210204ULL, 0x0400800040008021ULL,
+    0x0400400020005000ULL, 0x8240801000200080ULL, 0x8611001004200900ULL,
+    0x008180800C001800ULL, 0x0100800200800400ULL, 0x0A02000102000408ULL,
+    0x8020802300104280ULL, 0x0080004000402000ULL, 0xE010104000402000ULL,
+    0x0800808010002000ULL, 0xA280210008100100ULL, 0x0001818014000800ULL,
+    0xA002010100080400ULL, 0x0080240001020870ULL, 0x0001020004048845ULL,
+    0x0081826280004004ULL, 0x2020810900284000ULL, 0x0200100080802000ULL,
+    0x0200080080100080ULL, 0x8083080100100500ULL, 0x4406000901000400ULL,
+    0x0005020080800100ULL, 0x0090204200008114ULL, 0x0010400094800420ULL,
+    0x0900804000802002ULL, 0x0201001841002000ULL, 0x4100080080801000ULL,
+    0x4540040080800800ULL, 0x0002001004040020ULL, 0x0281195814001002ULL,
+    0x1240800040800100ULL, 0x0880042000524004ULL, 0x02C080410206002CULL,
+    0x0801200241050010ULL, 0x8400080010008080ULL, 0x0008000500090010ULL,
+    0x0082009084020008ULL, 0x4012000108020004ULL, 0x9000104D08860004ULL,
+    0x2004204114800100ULL, 0x0148802112400300ULL, 0x0202842000100880ULL,
+    0x001B080080900080ULL, 0x001A002008100600ULL, 0x0004008004020080ULL,
+    0x5181000600040300ULL, 0x0000044401128A00ULL, 0x8044110480002441ULL,
+    0x2008110084402202ULL, 0x90806005090010C1ULL, 0x000420310A004A42ULL,
+    0x0023001004020801ULL, 0x0882001008040102ULL, 0x000230088118020CULL,
+    0x0000019025040042ULL
+};
+
+constexpr Bitboard BishopMagicNumbers[64] = {
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL,
+    0x5204042080000088ULL, 0x2204106880000002ULL, 0x1401042004000000ULL,
+    0x0400880410042004ULL, 0x0028208200A02020ULL, 0x1500241990010E00ULL,
+    0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL,
+    0x8000088400880520ULL, 0x0405004010040100ULL, 0x1005823210040108ULL,
+    0x2708008102040011ULL, 0x4048200404009100ULL, 0x0018104101400024ULL,
+    0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL,
+    0x0894080000220040ULL, 0x1001010083104000ULL, 0x5004030040900080ULL,
+    0x000400422C012400ULL, 0x0002128698404812ULL, 0x1010108404900440ULL,
+    0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL,
+    0x802A02020000B098ULL, 0x0009015090004060ULL, 0x4000821082081001ULL,
+    0x0100210040420800ULL, 0x0800004010488A00ULL, 0x2000081104004040ULL,
+    0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL,
+    0x3040290220884800ULL, 0x4A1500401041004AULL, 0x8010200282020781ULL,
+    0x0020203142209091ULL, 0x0070300600902110ULL, 0x0040808800B62048ULL,
+    0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL,
+    0x4040702400932244ULL
+};
+
+uint64_t nextRandom(uint64_t &state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+void initMagics(Magic *magics, Bitboard *table, bool rook)
+{
+    Bitboard occupancy[4096];
+    Bitboard reference[4096];
+    int epoch[4096] = {};
+    int attempt = 0;
+    uint64_t seed = rook ? 0x2545F4914F6CDD1DULL : 0x9E3779B97F4A7C15ULL;
+
+    for (int sq = 0; sq < 64; ++sq) {
+        Magic &m = magics[sq];
+        m.mask = relevantMask(sq, rook);
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = sq == 0 ? table : magics[sq - 1].attacks +
+                                          (1ULL << (64 - magics[sq - 1].shift));
+
+        // Перебор всех подмножеств маски (Carry-Rippler)
+        int size = 0;
+        Bitboard subset = 0;
+        do {
+            occupancy[size] = subset;
+            reference[size] = slidingAttacks(sq, subset, rook);
+            ++size;
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+
+        if (UsePext) {
+            m.magic = 0;
+            for (int i = 0; i < size; ++i) {
+                m.attacks[magicIndex(m, occupancy[i])] = reference[i];
+            }
+            continue;
+        }
+
+        // Берём готовое magic-число, а при коллизии ищем новое
+        m.magic = rook ? RookMagicNumbers[sq] : BishopMagicNumbers[sq];
+        for (;;) {
+            ++attempt;
+            int i = 0;
+            for (; i < size; ++i) {
+                const unsigned idx = magicIndex(m, occupancy[i]);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+            if (i == size) {
+                break;
+            }
+
+            m.magic = 0;
+            while (popCount((m.mask * m.magic) >> 56) < 6) {
+                m.magic = nextRandom(seed) & nextRandom(seed) & nextRandom(seed);
+            }
+        }
+    }
+}
+
+} // namespace
+
+PieceType pieceTypeOf(char piece)
+{
+    switch (toupper(piece)) {
+    case 'P':
+        return PT_PAWN;
+    case 'N':
+        return PT_KNIGHT;
+    case 'B':
+        return PT_BISHOP;
+    case 'R':
+        return PT_ROOK;
+    case 'Q':
+        return PT_QUEEN;
+    case 'K':
+        return PT_KING;
+    default:
+        return PT_NONE;
+    }
+}
+
+char pieceChar(Color color, PieceType type)
+{
+    static const char symbols[] = "PNBRQK.";
+    const char c = symbols[type];
+    return color == BLACK ? static_cast<char>(tolower(c)) : c;
+}
+
+namespace {
+
+void buildBitboards()
+{
+#ifdef HAS_PEXT
+    __builtin_cpu_init();
+    UsePext = __builtin_cpu_supports("bmi2");
+#endif
+
+    const int knightOffsets[8][2] = {
+        {2,  1 },
+        {2,  -1},
+        {-2, 1 },
+        {-2, -1},
+        {1,  2 },
+        {1,  -2},
+        {-1, 2 },
+        {-1, -2}
+    };
+    const int kingOffsets[8][2] = {
+        {-1, -1},
+        {-1, 0 },
+        {-1, 1 },
+        {0,  -1},
+        {0,  1 },
+        {1,  -1},
+        {1,  0 },
+        {1,  1 }
+    };
+    // Белые пешки бьют в сторону уменьшения x, чёрные - увеличения
+    const int whitePawnOffsets[2][2] = {
+        {-1, -1},
+        {-1, 1 }
+    };
+    const int blackPawnOffsets[2][2] = {
+        {1, -1},
+        {1, 1 }
+    };
+
+    for (int sq = 0; sq < 64; ++sq) {
+        KnightAttacks[sq] = offsetsMask(sq, knightOffsets, 8);
+        KingAttacks[sq] = offsetsMask(sq, kingOffsets, 8);
+        PawnAttacks[WHITE][sq] = offsetsMask(sq, whitePawnOffsets, 2);
+        PawnAttacks[BLACK][sq] = offsetsMask(sq, blackPawnOffsets, 2);
+
+        for (int dir = 0; dir < 8; ++dir) {
+            Rays[dir][sq] = 0;
+            int nx = squareX(sq) + rayDirections[dir][0];
+            int ny = squareY(sq) + rayDirections[dir][1];
+            while (nx >= 0 && nx < 8 && ny >= 0 && ny < 8) {
+                Rays[dir][sq] |= squareBB(makeSquare(nx, ny));
+                nx += rayDirections[dir][0];
+                ny += rayDirections[dir][1];
+            }
+        }
+    }
+
+    initMagics(RookMagics, RookTable, true);
+    initMagics(BishopMagics, BishopTable, false);
+
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            BetweenBB[a][b] = 0;
+            LineBB[a][b] = 0;
+            if (a == b) {
+                continue;
+            }
+            const Bitboard ends = squareBB(a) | squareBB(b);
+            if (rookAttacks(a, 0) & squareBB(b)) {
+                LineBB[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | ends;
+                BetweenBB[a][b] =
+                    rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+            } else if (bishopAttacks(a, 0) & squareBB(b)) {
+                LineBB[a][b] =
+                    (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | ends;
+                BetweenBB[a][b] = bishopAttacks(a, squareBB(b)) &
+                                  bishopAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
+
+} // namespace
+
+void initBitboards()
+{
+    // Первыми таблицы могут запросить сразу несколько потоков
+    static std::once_flag once;
+    std::call_once(once, buildBitboards);
+}
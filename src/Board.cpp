@@ -1,59 +1,329 @@
 #include "../include/Board.h"
+#include "../include/Psqt.h"
+#include "../include/SearchStats.h"
+#include "../include/Zobrist.h"
 #include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
-// Доделать рокировку под шахом и взятие пешки на проходе
-
-Move::Move(int frX, int frY, int tX, int tY)
-    : fromX(frX), fromY(frY), toX(tX), toY(tY)
+Move::Move(int frX, int frY, int tX, int tY) : data(0)
 {
+    if (frX >= 0 && frX < 8 && frY >= 0 && frY < 8 && tX >= 0 && tX < 8 &&
+        tY >= 0 && tY < 8) {
+        *this = Move(makeSquare(frX, frY), makeSquare(tX, tY), QUIET);
+    }
 }
 
 bool Move::isValid() const
 {
-    return fromX >= 0 && fromX < 8 && fromY >= 0 && fromY < 8 && toX >= 0 &&
-           toX < 8 && toY >= 0 && toY < 8;
+    return from() != to();
 }
 
 Move Move::fromChessNotation(const std::string &from, const std::string &to)
 {
-    if (from.length() != 2 || to.length() != 2) {
+    if (from.length() != 2 || (to.length() != 2 && to.length() != 3)) {
         throw std::invalid_argument("Некорректный формат хода");
     }
 
-    return Move(8 - (from[1] - '0'), // row (1-8 -> 0-7)
-                from[0] - 'a',       // col (a-h -> 0-7)
-                8 - (to[1] - '0'),   // row
-                to[0] - 'a'          // col
+    Move move(8 - (from[1] - '0'), // row (1-8 -> 0-7)
+              from[0] - 'a',       // col (a-h -> 0-7)
+              8 - (to[1] - '0'),   // row
+              to[0] - 'a'          // col
     );
+
+    // Необязательная фигура превращения: e7 e8n
+    if (to.length() == 3 && move.isValid()) {
+        const PieceType promotion = pieceTypeOf(to[2]);
+        if (promotion < PT_KNIGHT || promotion > PT_QUEEN) {
+            throw std::invalid_argument("Некорректная фигура превращения");
+        }
+        move = Move(move.from(), move.to(), PROMOTION + (promotion - PT_KNIGHT));
+    }
+    return move;
 }
 
 std::string Move::toChessNotation() const
 {
-    return std::string(1, 'a' + fromY) + std::to_string(8 - fromX) + " " +
-           std::string(1, 'a' + toY) + std::to_string(8 - toX);
+    std::string result = std::string(1, 'a' + fromY()) +
+                         std::to_string(8 - fromX()) + " " +
+                         std::string(1, 'a' + toY()) + std::to_string(8 - toX());
+    if (isPromotion()) {
+        result += pieceChar(BLACK, promotionType());
+    }
+    return result;
+}
+
+std::string Move::toUci() const
+{
+    std::string result = toChessNotation();
+    result.erase(2, 1);
+    return result;
 }
 
 Board::Board()
 {
+    initBitboards();
+    initZobrist();
+    initPsqt();
     resetBoard();
-    memset(kingHasMoved, 0, sizeof(kingHasMoved));
-    memset(castlingRights, 1, sizeof(castlingRights));
 }
 
 bool Board::isValidMove(const Move &move, bool isWhiteTurn) const
 {
-    if (!isInBounds(move.fromX, move.fromY) ||
-        isWhite(move.fromX, move.fromY) != isWhiteTurn) {
+    if (!move.isValid() || isWhite(move.fromX(), move.fromY()) != isWhiteTurn) {
         return false;
     }
 
-    auto possibleMoves = generateAllMoves(isWhiteTurn);
+    return findLegalMove(move, isWhiteTurn).isValid();
+}
+
+Move Board::findLegalMove(const Move &move, bool isWhiteTurn) const
+{
+    // Ход из нотации не знает флагов: ищем легальный ход с теми же клетками.
+    // Без указанной фигуры превращения пешка становится ферзём
+    const MoveList moves = generateAllMoves(isWhiteTurn);
+    for (const Move &candidate : moves) {
+        if (!candidate.sameSquares(move)) {
+            continue;
+        }
+        const PieceType wanted =
+            move.isPromotion() ? move.promotionType() : PT_QUEEN;
+        if (!candidate.isPromotion() || candidate.promotionType() == wanted) {
+            return candidate;
+        }
+    }
+    return Move();
+}
+
+Board Board::fromFEN(const std::string &fen)
+{
+    std::istringstream in(fen);
+    std::string placement, side, castling, ep;
+    if (!(in >> placement >> side >> castling >> ep)) {
+        throw std::invalid_argument("Некорректный FEN: " + fen);
+    }
+
+    // Счётчики ходов необязательны, как в EPD
+    int halfmove = 0;
+    int fullmove = 1;
+    if (in >> halfmove) {
+        if (!(in >> fullmove) || halfmove < 0 || fullmove < 1) {
+            throw std::invalid_argument("Некорректный FEN: " + fen);
+        }
+    } else if (!in.eof()) {
+        throw std::invalid_argument("Некорректный FEN: " + fen);
+    }
+
+    Board result;
+    memset(result.board, EMPTY, sizeof(result.board));
+
+    // Горизонтали в FEN идут с восьмой, как и строки board[x]
+    int x = 0;
+    int y = 0;
+    for (const char c : placement) {
+        if (c == '/') {
+            ++x;
+            y = 0;
+        } else if (isdigit(c)) {
+            y += c - '0';
+        } else if (pieceTypeOf(c) != PT_NONE && x < 8 && y < 8) {
+            result.board[x][y++] = c;
+        } else {
+            throw std::invalid_argument("Некорректный FEN: " + fen);
+        }
+        if (x > 7 || y > 8) {
+            throw std::invalid_argument("Некорректный FEN: " + fen);
+        }
+    }
+
+    if (side != "w" && side != "b") {
+        throw std::invalid_argument("Некорректный FEN: " + fen);
+    }
+    result.whiteToMove = side == "w";
+
+    memset(result.castlingRights, 0, sizeof(result.castlingRights));
+    memset(result.kingHasMoved, 0, sizeof(result.kingHasMoved));
+    for (const char c : castling) {
+        if (c == 'K') {
+            result.castlingRights[WHITE][0] = true;
+        } else if (c == 'Q') {
+            result.castlingRights[WHITE][1] = true;
+        } else if (c == 'k') {
+            result.castlingRights[BLACK][0] = true;
+        } else if (c == 'q') {
+            result.castlingRights[BLACK][1] = true;
+        } else if (c != '-') {
+            throw std::invalid_argument("Некорректный FEN: " + fen);
+        }
+    }
+
+    result.epSquare = -1;
+    if (ep != "-") {
+        if (ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || ep[1] < '1' ||
+            ep[1] > '8') {
+            throw std::invalid_argument("Некорректный FEN: " + fen);
+        }
+        result.epSquare = makeSquare(8 - (ep[1] - '0'), ep[0] - 'a');
+    }
+    result.halfmoveClock = halfmove;
+    result.fullmoveNumber = fullmove;
+
+    result.syncBitboards();
+    return result;
+}
+
+std::string Board::toFEN() const
+{
+    std::string fen;
+    for (int x = 0; x < 8; ++x) {
+        int empty = 0;
+        for (int y = 0; y < 8; ++y) {
+            if (board[x][y] == EMPTY) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                fen += static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            fen += board[x][y];
+        }
+        if (empty > 0) {
+            fen += static_cast<char>('0' + empty);
+        }
+        if (x < 7) {
+            fen += '/';
+        }
+    }
+
+    fen += whiteToMove ? " w " : " b ";
+
+    const std::string castlingChars = "KQkq";
+    std::string castling;
+    for (int color = 0; color < 2; ++color) {
+        for (int side = 0; side < 2; ++side) {
+            if (castlingRights[color][side] && !kingHasMoved[color]) {
+                castling += castlingChars[color * 2 + side];
+            }
+        }
+    }
+    fen += castling.empty() ? "-" : castling;
+
+    if (epSquare >= 0) {
+        fen += ' ';
+        fen += static_cast<char>('a' + squareY(epSquare));
+        fen += std::to_string(8 - squareX(epSquare));
+    } else {
+        fen += " -";
+    }
+
+    fen += " " + std::to_string(halfmoveClock) + " " +
+           std::to_string(fullmoveNumber);
+    return fen;
+}
+
+std::string Board::sanBody(const Move &move) const
+{
+    if (move.flags() == Move::KING_CASTLE) {
+        return "O-O";
+    }
+    if (move.flags() == Move::QUEEN_CASTLE) {
+        return "O-O-O";
+    }
+
+    const char piece = board[move.fromX()][move.fromY()];
+    const PieceType type = pieceTypeOf(piece);
+    const std::string target = move.toUci().substr(2, 2);
+    std::string san;
+
+    if (type == PT_PAWN) {
+        if (move.isCapture()) {
+            san += static_cast<char>('a' + move.fromY());
+            san += 'x';
+        }
+        san += target;
+        if (move.isPromotion()) {
+            san += '=';
+            san += pieceChar(WHITE, move.promotionType());
+        }
+        return san;
+    }
+
+    san += pieceChar(WHITE, type);
+
+    // Если на ту же клетку может пойти такая же фигура, указываем
+    // вертикаль, а если и она совпадает - горизонталь
+    const Color us = isupper(piece) ? WHITE : BLACK;
+    MoveList rivals;
+    generateMoves(us == WHITE, GEN_ALL, rivals, pieces[us][type]);
+    bool ambiguous = false;
+    bool sameFile = false;
+    bool sameRank = false;
+    for (const Move &other : rivals) {
+        if (other.to() != move.to() || other.from() == move.from()) {
+            continue;
+        }
+        ambiguous = true;
+        sameFile |= other.fromY() == move.fromY();
+        sameRank |= other.fromX() == move.fromX();
+    }
+    if (ambiguous && (!sameFile || sameRank)) {
+        san += static_cast<char>('a' + move.fromY());
+    }
+    if (ambiguous && sameFile) {
+        san += static_cast<char>('0' + 8 - move.fromX());
+    }
+
+    if (move.isCapture()) {
+        san += 'x';
+    }
+    return san + target;
+}
+
+std::string Board::toSan(const Move &move) const
+{
+    Board next = *this;
+    UndoInfo undo;
+    next.doMove(move, undo);
+    const NodeStatus status = next.nodeStatus(next.whiteToMove);
+
+    std::string san = sanBody(move);
+    if (status.isCheckmate()) {
+        san += '#';
+    } else if (status.inCheck) {
+        san += '+';
+    }
+    return san;
+}
+
+Move Board::parseSan(const std::string &text) const
+{
+    // Сравниваем без пометок шаха и оценок, "=" при превращении и нули
+    // в рокировке встречаются не во всех файлах
+    auto normalize = [](const std::string &san) {
+        std::string result;
+        for (const char c : san) {
+            if (c == '0') {
+                result += 'O';
+            } else if (c != '+' && c != '#' && c != '!' && c != '?' &&
+                       c != '=') {
+                result += c;
+            }
+        }
+        return result;
+    };
 
-    return std::any_of(possibleMoves.begin(),
-                       possibleMoves.end(),
-                       [&move](const Move &m) { return m == move; });
+    const std::string wanted = normalize(text);
+    const MoveList moves = generateAllMoves(whiteToMove);
+    for (const Move &move : moves) {
+        if (normalize(sanBody(move)) == wanted || move.toUci() == text) {
+            return move;
+        }
+    }
+    return Move();
 }
 
 void Board::resetBoard()
@@ -69,6 +339,112 @@ void Board::resetBoard()
         {'R',   'N',   'B',   'Q',   'K',   'B',   'N',   'R'  }
     };
     memcpy(board, initialBoard, sizeof(board));
+    memset(kingHasMoved, 0, sizeof(kingHasMoved));
+    memset(castlingRights, 1, sizeof(castlingRights));
+    epSquare = -1;
+    whiteToMove = true;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    syncBitboards();
+}
+
+void Board::syncBitboards()
+{
+    memset(pieces, 0, sizeof(pieces));
+    memset(occupied, 0, sizeof(occupied));
+    occupiedAll = 0;
+    psqtMg = 0;
+    psqtEg = 0;
+    phase = 0;
+
+    for (int sq = 0; sq < 64; ++sq) {
+        const char piece = board[squareX(sq)][squareY(sq)];
+        if (piece != EMPTY) {
+            const Color color = isupper(piece) ? WHITE : BLACK;
+            const PieceType type = pieceTypeOf(piece);
+            pieces[color][type] |= squareBB(sq);
+            occupied[color] |= squareBB(sq);
+            occupiedAll |= squareBB(sq);
+            psqtMg += PsqtMg[color][type][sq];
+            psqtEg += PsqtEg[color][type][sq];
+            phase += PhaseWeight[type];
+        }
+    }
+    hashKey = computeHash();
+}
+
+int Board::castlingIndex() const
+{
+    int index = 0;
+    for (int color = 0; color < 2; ++color) {
+        for (int side = 0; side < 2; ++side) {
+            if (castlingRights[color][side] && !kingHasMoved[color]) {
+                index |= 1 << (color * 2 + side);
+            }
+        }
+    }
+    return index;
+}
+
+uint64_t Board::computeHash() const
+{
+    uint64_t key = 0;
+    for (int color = 0; color < 2; ++color) {
+        for (int type = PT_PAWN; type <= PT_KING; ++type) {
+            Bitboard bb = pieces[color][type];
+            while (bb) {
+                key ^= Zobrist.pieces[color][type][popLsb(bb)];
+            }
+        }
+    }
+    key ^= Zobrist.castling[castlingIndex()];
+    if (epSquare >= 0) {
+        key ^= Zobrist.epFile[squareY(epSquare)];
+    }
+    if (!whiteToMove) {
+        key ^= Zobrist.side;
+    }
+    return key;
+}
+
+void Board::putPiece(int sq, char piece)
+{
+    const Color color = isupper(piece) ? WHITE : BLACK;
+    const PieceType type = pieceTypeOf(piece);
+    board[squareX(sq)][squareY(sq)] = piece;
+    hashKey ^= Zobrist.pieces[color][type][sq];
+    psqtMg += PsqtMg[color][type][sq];
+    psqtEg += PsqtEg[color][type][sq];
+    phase += PhaseWeight[type];
+    pieces[color][type] |= squareBB(sq);
+    occupied[color] |= squareBB(sq);
+    occupiedAll |= squareBB(sq);
+}
+
+void Board::removePiece(int sq)
+{
+    const char piece = board[squareX(sq)][squareY(sq)];
+    if (piece == EMPTY) {
+        return;
+    }
+    const Color color = isupper(piece) ? WHITE : BLACK;
+    const PieceType type = pieceTypeOf(piece);
+    board[squareX(sq)][squareY(sq)] = EMPTY;
+    hashKey ^= Zobrist.pieces[color][type][sq];
+    psqtMg -= PsqtMg[color][type][sq];
+    psqtEg -= PsqtEg[color][type][sq];
+    phase -= PhaseWeight[type];
+    pieces[color][type] &= ~squareBB(sq);
+    occupied[color] &= ~squareBB(sq);
+    occupiedAll &= ~squareBB(sq);
+}
+
+void Board::movePiece(int from, int to)
+{
+    const char piece = board[squareX(from)][squareY(from)];
+    removePiece(to);
+    removePiece(from);
+    putPiece(to, piece);
 }
 
 void Board::print() const
@@ -89,84 +465,175 @@ bool Board::isWhite(int x, int y) const
     if (!isInBounds(x, y)) {
         return false;
     }
-    return isupper(board[x][y]);
+    return (occupied[WHITE] & squareBB(makeSquare(x, y))) != 0;
 }
 
 bool Board::makeMove(const Move &move)
 {
-    if (!move.isValid() || isEmpty(move.fromX, move.fromY))
+    if (!move.isValid() || isEmpty(move.fromX(), move.fromY()))
         return false;
 
-    char movingPiece = board[move.fromX][move.fromY];
-    bool isWhiteMove = isupper(movingPiece);
+    const Move legal =
+        findLegalMove(move, isWhite(move.fromX(), move.fromY()));
+    if (!legal.isValid())
+        return false;
 
-    Board tempBoard = *this;
+    UndoInfo undo;
+    doMove(legal, undo);
+    return true;
+}
 
-    tempBoard.board[move.toX][move.toY] = movingPiece;
-    tempBoard.board[move.fromX][move.fromY] = EMPTY;
+void Board::doMove(const Move &move, UndoInfo &undo)
+{
+    const int from = move.from();
+    const int to = move.to();
+    const int flags = move.flags();
+    const char movingPiece = board[squareX(from)][squareY(from)];
+    const bool isWhiteMove = isupper(movingPiece);
+    const int row = squareX(from);
+
+    undo.movedPiece = movingPiece;
+    undo.capturedPiece = board[squareX(to)][squareY(to)];
+    undo.epSquare = epSquare;
+    undo.whiteToMove = whiteToMove;
+    undo.halfmoveClock = halfmoveClock;
+    undo.hashKey = hashKey;
+    memcpy(undo.castlingRights, castlingRights, sizeof(castlingRights));
+    memcpy(undo.kingHasMoved, kingHasMoved, sizeof(kingHasMoved));
+
+    // Убираем из ключа старые права рокировки, взятие на проходе и очередь
+    hashKey ^= Zobrist.castling[castlingIndex()];
+    if (epSquare >= 0) {
+        hashKey ^= Zobrist.epFile[squareY(epSquare)];
+    }
+    if (!whiteToMove) {
+        hashKey ^= Zobrist.side;
+    }
 
-    if (tempBoard.isCheck(isWhiteMove)) {
-        return false;
+    if (flags == Move::EN_PASSANT) {
+        // Побитая пешка стоит рядом, а не на клетке хода
+        const int capturedSq = makeSquare(row, squareY(to));
+        undo.capturedPiece = board[row][squareY(to)];
+        removePiece(capturedSq);
     }
 
-    if (tolower(movingPiece) == 'k' && abs(move.fromY - move.toY) == 2) {
-        if (move.toY > move.fromY) {
-            if (!canCastleKingside(isWhiteMove))
-                return false;
-            tempBoard.board[move.fromX][5] = tempBoard.board[move.fromX][7];
-            tempBoard.board[move.fromX][7] = EMPTY;
-        } else {
-            if (!canCastleQueenside(isWhiteMove))
-                return false;
-            tempBoard.board[move.fromX][3] = tempBoard.board[move.fromX][0];
-            tempBoard.board[move.fromX][0] = EMPTY;
-        }
+    movePiece(from, to);
+    epSquare = -1;
+
+    if (flags == Move::DOUBLE_PUSH) {
+        epSquare = (from + to) / 2;
+    } else if (move.isPromotion()) {
+        removePiece(to);
+        putPiece(to,
+                 pieceChar(isWhiteMove ? WHITE : BLACK, move.promotionType()));
+    } else if (flags == Move::KING_CASTLE) {
+        movePiece(makeSquare(row, 7), makeSquare(row, 5));
+    } else if (flags == Move::QUEEN_CASTLE) {
+        movePiece(makeSquare(row, 0), makeSquare(row, 3));
+    }
+
+    if (pieceTypeOf(movingPiece) == PT_KING) {
+        kingHasMoved[isWhiteMove ? 0 : 1] = true;
     }
 
-    if (tolower(movingPiece) == 'p' && (move.toX == 0 || move.toX == 7)) {
-        tempBoard.board[move.toX][move.toY] =
-            isWhiteMove ? 'Q' : 'q'; // Автоматически в ферзя
+    // Ход с угловой клетки или на неё лишает права рокировки с этой ладьёй
+    constexpr int rookCorners[2][2] = {
+        {makeSquare(7, 7), makeSquare(7, 0)},
+        {makeSquare(0, 7), makeSquare(0, 0)}
+    };
+    for (int color = 0; color < 2; ++color) {
+        for (int side = 0; side < 2; ++side) {
+            const int corner = rookCorners[color][side];
+            if (from == corner || to == corner) {
+                castlingRights[color][side] = false;
+            }
+        }
     }
 
-    *this = tempBoard;
+    // Правило 50 ходов считает полуходы с последнего взятия или хода пешкой
+    if (pieceTypeOf(movingPiece) == PT_PAWN || undo.capturedPiece != EMPTY) {
+        halfmoveClock = 0;
+    } else {
+        ++halfmoveClock;
+    }
+    if (!isWhiteMove) {
+        ++fullmoveNumber;
+    }
 
-    if (tolower(movingPiece) == 'k') {
-        kingHasMoved[isWhiteMove ? 0 : 1] = true;
+    whiteToMove = !isWhiteMove;
+    hashKey ^= Zobrist.castling[castlingIndex()];
+    if (epSquare >= 0) {
+        hashKey ^= Zobrist.epFile[squareY(epSquare)];
     }
-    if (tolower(movingPiece) == 'r') {
-        if (move.fromY == 0)
-            castlingRights[isWhiteMove ? 0 : 1][1] = false;
-        else if (move.fromY == 7)
-            castlingRights[isWhiteMove ? 0 : 1][0] = false;
+    if (!whiteToMove) {
+        hashKey ^= Zobrist.side;
     }
 
-    return true;
+#ifdef DEBUG_HASH
+    assert(hashKey == computeHash());
+#endif
 }
 
-bool Board::canCastle(bool isWhite, bool kingside) const
+void Board::undoMove(const Move &move, const UndoInfo &undo)
 {
-    if (hasKingMoved(isWhite))
-        return false;
+    const int from = move.from();
+    const int to = move.to();
+    const int flags = move.flags();
+    const int row = squareX(from);
+
+    if (flags == Move::KING_CASTLE) {
+        movePiece(makeSquare(row, 5), makeSquare(row, 7));
+    } else if (flags == Move::QUEEN_CASTLE) {
+        movePiece(makeSquare(row, 3), makeSquare(row, 0));
+    }
 
-    int row = isWhite ? 7 : 0;
-    int rookCol = kingside ? 7 : 0;
+    removePiece(to);
+    putPiece(from, undo.movedPiece);
 
-    char expectedRook = isWhite ? 'R' : 'r';
-    if (board[row][rookCol] != expectedRook)
-        return false;
+    if (flags == Move::EN_PASSANT) {
+        putPiece(makeSquare(row, squareY(to)), undo.capturedPiece);
+    } else if (undo.capturedPiece != EMPTY) {
+        putPiece(to, undo.capturedPiece);
+    }
 
-    int start = kingside ? 4 : 0;
-    int end = kingside ? 7 : 4;
-    int step = kingside ? 1 : -1;
+    epSquare = undo.epSquare;
+    whiteToMove = undo.whiteToMove;
+    halfmoveClock = undo.halfmoveClock;
+    if (!whiteToMove) {
+        --fullmoveNumber;
+    }
+    hashKey = undo.hashKey;
+    memcpy(castlingRights, undo.castlingRights, sizeof(castlingRights));
+    memcpy(kingHasMoved, undo.kingHasMoved, sizeof(kingHasMoved));
 
-    for (int col = start + step; col != end; col += step) {
-        if (board[row][col] != EMPTY)
-            return false;
-        if (isSquareUnderAttack(row, col, !isWhite))
-            return false;
+#ifdef DEBUG_HASH
+    assert(hashKey == computeHash());
+#endif
+}
+
+void Board::doNullMove(UndoInfo &undo)
+{
+    // Пропуск хода: меняется только очередь и пропадает взятие на проходе
+    undo.epSquare = epSquare;
+    undo.whiteToMove = whiteToMove;
+    undo.halfmoveClock = halfmoveClock;
+    undo.hashKey = hashKey;
+
+    if (epSquare >= 0) {
+        hashKey ^= Zobrist.epFile[squareY(epSquare)];
+        epSquare = -1;
     }
+    whiteToMove = !whiteToMove;
+    ++halfmoveClock;
+    hashKey ^= Zobrist.side;
+}
 
-    return true;
+void Board::undoNullMove(const UndoInfo &undo)
+{
+    epSquare = undo.epSquare;
+    whiteToMove = undo.whiteToMove;
+    halfmoveClock = undo.halfmoveClock;
+    hashKey = undo.hashKey;
 }
 
 bool Board::isInBounds(int x, int y) const
@@ -176,36 +643,21 @@ bool Board::isInBounds(int x, int y) const
 
 bool Board::isEmpty(int x, int y) const
 {
-    return isInBounds(x, y) && board[x][y] == EMPTY;
+    return isInBounds(x, y) && !(occupiedAll & squareBB(makeSquare(x, y)));
 }
 
-bool Board::isEnemy(int x, int y, bool isWhite) const
+int Board::kingSquare(Color color) const
 {
-    if (!isInBounds(x, y))
-        return false;
-    char piece = board[x][y];
-    return isWhite ? islower(piece) : isupper(piece);
-}
-
-bool Board::isAlly(int x, int y, bool isWhite) const
-{
-    if (!isInBounds(x, y))
-        return false;
-    char piece = board[x][y];
-    return isWhite ? isupper(piece) : islower(piece);
+    const Bitboard king = pieces[color][PT_KING];
+    return king ? lsb(king) : -1;
 }
 
 bool Board::isCheck(bool isWhite) const
 {
-    char king = isWhite ? 'K' : 'k';
-    for (int x = 0; x < 8; x++) {
-        for (int y = 0; y < 8; y++) {
-            if (board[x][y] == king) {
-                return isSquareUnderAttack(x, y, !isWhite);
-            }
-        }
-    }
-    return false;
+    const int king = kingSquare(isWhite ? WHITE : BLACK);
+    if (king < 0)
+        return false;
+    return isSquareAttacked(king, isWhite ? BLACK : WHITE);
 }
 
 bool Board::isCheckmate(bool isWhite) const
@@ -213,59 +665,21 @@ bool Board::isCheckmate(bool isWhite) const
     if (!isCheck(isWhite))
         return false;
 
-    auto moves = generateAllMoves(isWhite);
-    for (const Move &move : moves) {
-        Board tempBoard = *this;
-        if (tempBoard.makeMove(move)) {
-            if (!tempBoard.isCheck(isWhite)) {
-                return false;
-            }
-        }
-    }
-
-    return true;
-}
-
-bool Board::hasKingMoved(bool isWhite) const
-{
-    return kingHasMoved[isWhite ? 0 : 1];
-}
-
-bool Board::canCastleKingside(bool isWhite) const
-{
-    const int y = isWhite ? 7 : 0;
-    return castlingRights[isWhite ? 0 : 1][0] &&
-           isPathClearForCastling(y, 4, 7) && !isCheck(isWhite);
+    // generateAllMoves отдаёт только ходы, после которых король не под шахом
+    return generateAllMoves(isWhite).empty();
 }
 
-bool Board::canCastleQueenside(bool isWhite) const
+NodeStatus Board::nodeStatus(bool isWhite) const
 {
-    const int y = isWhite ? 7 : 0;
-    return castlingRights[isWhite ? 0 : 1][1] &&
-           isPathClearForCastling(y, 0, 4) && !isCheck(isWhite);
+    NodeStatus status;
+    status.inCheck = isCheck(isWhite);
+    generateMoves(isWhite, GEN_ALL, status.moves);
+    return status;
 }
 
-bool Board::isPathClearForCastling(int row, int startCol, int endCol) const
+bool Board::hasKingMoved(bool isWhite) const
 {
-    bool isWhiteTurn = (row == 7);
-
-    if (isCheck(isWhiteTurn)) {
-        return false;
-    }
-
-    const int step = (startCol < endCol) ? 1 : -1;
-
-    for (int col = startCol + step; col != endCol; col += step) {
-        if (board[row][col] != EMPTY) {
-            return false;
-        }
-
-        if (col != endCol && isSquareUnderAttack(row, col, !isWhiteTurn)) {
-            return false;
-        }
-    }
-
-    return true;
+    return kingHasMoved[isWhite ? 0 : 1];
 }
 
 bool Board::isStalemate(bool isWhite) const
@@ -275,326 +689,378 @@ bool Board::isStalemate(bool isWhite) const
     return generateAllMoves(isWhite).empty();
 }
 
-void Board::generatePawnMoves(int x,
-                              int y,
+void Board::generatePawnMoves(int from,
                               bool isWhite,
-                              std::vector<Move> &moves) const
+                              Bitboard allowed,
+                              GenType type,
+                              MoveList &moves) const
 {
-    const int direction = isWhite ? -1 : 1;
+    const Color us = isWhite ? WHITE : BLACK;
+    const int direction = isWhite ? -8 : 8;
     const int startRow = isWhite ? 6 : 1;
+    const int promotionRow = isWhite ? 0 : 7;
+    const int x = squareX(from);
+
+    // На последней горизонтали - все четыре превращения, ферзь первым
+    auto addMove = [&](int to, bool capture) {
+        if (squareX(to) == promotionRow) {
+            const int base =
+                capture ? Move::PROMOTION_CAPTURE : Move::PROMOTION;
+            for (int piece = PT_QUEEN; piece >= PT_KNIGHT; --piece) {
+                moves.add(Move(from, to, base + (piece - PT_KNIGHT)));
+            }
+        } else {
+            moves.add(Move(from, to, capture ? Move::CAPTURE : Move::QUIET));
+        }
+    };
 
-    if (isEmpty(x + direction, y)) {
-        moves.emplace_back(x, y, x + direction, y);
-        if (x == startRow && isEmpty(x + 2 * direction, y)) {
-            moves.emplace_back(x, y, x + 2 * direction, y);
+    // Превращение без взятия относится к взятиям: оно так же меняет материал
+    const int push = from + direction;
+    if (push >= 0 && push < 64 && !(occupiedAll & squareBB(push))) {
+        const bool promotion = squareX(push) == promotionRow;
+        if ((allowed & squareBB(push)) &&
+            (type == GEN_ALL || (type == GEN_CAPTURES) == promotion)) {
+            addMove(push, false);
+        }
+        const int doublePush = push + direction;
+        if (type != GEN_CAPTURES && x == startRow &&
+            !(occupiedAll & squareBB(doublePush)) &&
+            (allowed & squareBB(doublePush))) {
+            moves.add(Move(from, doublePush, Move::DOUBLE_PUSH));
         }
     }
 
-    for (int dy : {-1, 1}) {
-        if (isEnemy(x + direction, y + dy, isWhite)) {
-            moves.emplace_back(x, y, x + direction, y + dy);
+    if (type == GEN_QUIETS) {
+        return;
+    }
+
+    Bitboard captures =
+        PawnAttacks[us][from] & occupied[isWhite ? BLACK : WHITE] & allowed;
+    while (captures) {
+        addMove(popLsb(captures), true);
+    }
+
+    // На проходе бьёт только сторона, против которой сделан двойной ход.
+    // С доски уходят сразу две пешки, поэтому шах проверяем напрямую
+    if (epSquare >= 0 && squareX(epSquare) == (isWhite ? 2 : 5) &&
+        (PawnAttacks[us][from] & squareBB(epSquare))) {
+        const int king = kingSquare(us);
+        const Bitboard captured = squareBB(makeSquare(x, squareY(epSquare)));
+        const Bitboard occ =
+            (occupiedAll ^ squareBB(from) ^ captured) | squareBB(epSquare);
+        if (king < 0 || !(attackersTo(king, occ) &
+                          occupied[isWhite ? BLACK : WHITE] & ~captured)) {
+            moves.add(Move(from, epSquare, Move::EN_PASSANT));
         }
     }
 }
 
-void Board::generateRookMoves(int x,
-                              int y,
-                              bool isWhite,
-                              std::vector<Move> &moves) const
+void Board::generatePieceMoves(int from,
+                               Bitboard targets,
+                               MoveList &moves) const
 {
-    const std::pair<int, int> directions[] = {
-        {0,  1 },
-        {0,  -1},
-        {-1, 0 },
-        {1,  0 }
-    };
-    for (const auto &dir : directions) {
-        int dx = dir.first;
-        int dy = dir.second;
-
-        for (int step = 1; step < 8; step++) {
-            int newX = x + step * dx;
-            int newY = y + step * dy;
+    while (targets) {
+        const int to = popLsb(targets);
+        moves.add(Move(from,
+                       to,
+                       (occupiedAll & squareBB(to)) ? Move::CAPTURE
+                                                    : Move::QUIET));
+    }
+}
 
-            if (!isInBounds(newX, newY))
-                break;
+void Board::generateKingMoves(int from,
+                              bool isWhite,
+                              Bitboard danger,
+                              bool inCheck,
+                              GenType type,
+                              MoveList &moves) const
+{
+    const Color us = isWhite ? WHITE : BLACK;
+    const Bitboard targets = type == GEN_CAPTURES ? occupied[isWhite ? BLACK : WHITE]
+                             : type == GEN_QUIETS ? ~occupiedAll
+                                                  : ~occupied[us];
 
-            if (isAlly(newX, newY, isWhite))
-                break;
+    // Обычные ходы короля (1 клетка в любом направлении)
+    generatePieceMoves(from, KingAttacks[from] & targets & ~danger, moves);
 
-            if (isEnemy(newX, newY, isWhite)) {
-                moves.emplace_back(x, y, newX, newY);
-                break;
-            }
+    const int x = isWhite ? 7 : 0;
+    if (type == GEN_CAPTURES || inCheck || hasKingMoved(isWhite) ||
+        from != makeSquare(x, 4)) {
+        return;
+    }
 
-            else {
-                moves.emplace_back(x, y, newX, newY);
-            }
-        }
+    const char rook = isWhite ? 'R' : 'r';
+    // Между королём и ладьёй пусто, поля прохода короля не под боем
+    if (castlingRights[us][0] && board[x][7] == rook &&
+        !(BetweenBB[from][makeSquare(x, 7)] & occupiedAll) &&
+        !(BetweenBB[from][makeSquare(x, 7)] & danger)) {
+        moves.add(Move(from, makeSquare(x, 6), Move::KING_CASTLE));
+    }
+    if (castlingRights[us][1] && board[x][0] == rook &&
+        !(BetweenBB[from][makeSquare(x, 0)] & occupiedAll) &&
+        !((squareBB(makeSquare(x, 3)) | squareBB(makeSquare(x, 2))) & danger)) {
+        moves.add(Move(from, makeSquare(x, 2), Move::QUEEN_CASTLE));
     }
 }
 
-void Board::generateBishopMoves(int x,
-                                int y,
-                                bool isWhite,
-                                std::vector<Move> &moves) const
+Bitboard Board::attackersTo(int sq, Bitboard occ) const
 {
-    const std::pair<int, int> directions[] = {
-        {1,  1 },
-        {-1, -1},
-        {-1, 1 },
-        {1,  -1}
-    };
-    for (const auto &dir : directions) {
-        int dx = dir.first;
-        int dy = dir.second;
+    const Bitboard rooks = pieces[WHITE][PT_ROOK] | pieces[BLACK][PT_ROOK] |
+                           pieces[WHITE][PT_QUEEN] | pieces[BLACK][PT_QUEEN];
+    const Bitboard bishops = pieces[WHITE][PT_BISHOP] |
+                             pieces[BLACK][PT_BISHOP] |
+                             pieces[WHITE][PT_QUEEN] | pieces[BLACK][PT_QUEEN];
+
+    return (PawnAttacks[BLACK][sq] & pieces[WHITE][PT_PAWN]) |
+           (PawnAttacks[WHITE][sq] & pieces[BLACK][PT_PAWN]) |
+           (KnightAttacks[sq] &
+            (pieces[WHITE][PT_KNIGHT] | pieces[BLACK][PT_KNIGHT])) |
+           (KingAttacks[sq] & (pieces[WHITE][PT_KING] | pieces[BLACK][PT_KING])) |
+           (rookAttacks(sq, occ) & rooks) | (bishopAttacks(sq, occ) & bishops);
+}
 
-        for (int step = 1; step < 8; step++) {
-            int newX = x + step * dx;
-            int newY = y + step * dy;
+Bitboard Board::attackedSquares(Color by, Bitboard occ) const
+{
+    Bitboard result = 0;
 
-            if (!isInBounds(newX, newY))
-                break;
+    Bitboard bb = pieces[by][PT_PAWN];
+    while (bb) {
+        result |= PawnAttacks[by][popLsb(bb)];
+    }
+    bb = pieces[by][PT_KNIGHT];
+    while (bb) {
+        result |= KnightAttacks[popLsb(bb)];
+    }
+    bb = pieces[by][PT_BISHOP] | pieces[by][PT_QUEEN];
+    while (bb) {
+        result |= bishopAttacks(popLsb(bb), occ);
+    }
+    bb = pieces[by][PT_ROOK] | pieces[by][PT_QUEEN];
+    while (bb) {
+        result |= rookAttacks(popLsb(bb), occ);
+    }
+    bb = pieces[by][PT_KING];
+    while (bb) {
+        result |= KingAttacks[popLsb(bb)];
+    }
 
-            if (isAlly(newX, newY, isWhite))
-                break;
+    return result;
+}
 
-            if (isEnemy(newX, newY, isWhite)) {
-                moves.emplace_back(x, y, newX, newY);
-                break;
-            }
+Bitboard Board::pinnedPieces(Color color) const
+{
+    const int king = kingSquare(color);
+    if (king < 0) {
+        return 0;
+    }
 
-            else {
-                moves.emplace_back(x, y, newX, newY);
-            }
+    const Color them = color == WHITE ? BLACK : WHITE;
+    const Bitboard queens = pieces[them][PT_QUEEN];
+    Bitboard snipers =
+        (rookAttacks(king, 0) & (pieces[them][PT_ROOK] | queens)) |
+        (bishopAttacks(king, 0) & (pieces[them][PT_BISHOP] | queens));
+
+    Bitboard pinned = 0;
+    while (snipers) {
+        const Bitboard between = BetweenBB[king][popLsb(snipers)] & occupiedAll;
+        if (between && !(between & (between - 1)) && (between & occupied[color])) {
+            pinned |= between;
         }
     }
+    return pinned;
 }
 
-void Board::generateKnightMoves(int x,
-                                int y,
-                                bool isWhite,
-                                std::vector<Move> &moves) const
+bool Board::isSquareUnderAttack(int x, int y, bool byWhite) const
 {
-    // Все возможные смещения для хода коня (8 вариантов)
-    const std::array<std::pair<int, int>, 8> knightMoves = {
-        {
-         {2, 1},
-         {2, -1},
-         {-2, 1},
-         {-2, -1},
-         {1, 2},
-         {1, -2},
-         {-1, 2},
-         {-1, -2},
-         }
-    };
-
-    for (const auto &[dx, dy] : knightMoves) {
-        int newX = x + dx;
-        int newY = y + dy;
+    return isSquareAttacked(makeSquare(x, y), byWhite ? WHITE : BLACK);
+}
 
-        if (!isInBounds(newX, newY) || isAlly(newX, newY, isWhite))
-            continue;
+bool Board::isSquareAttacked(int sq, Color by) const
+{
+    const Color defender = by == WHITE ? BLACK : WHITE;
+
+    // Пешка атакует клетку, если с этой клетки пешка защищающейся стороны
+    // атаковала бы пешку
+    if (PawnAttacks[defender][sq] & pieces[by][PT_PAWN])
+        return true;
+    if (KnightAttacks[sq] & pieces[by][PT_KNIGHT])
+        return true;
+    if (KingAttacks[sq] & pieces[by][PT_KING])
+        return true;
+
+    const Bitboard queens = pieces[by][PT_QUEEN];
+    if (rookAttacks(sq, occupiedAll) & (pieces[by][PT_ROOK] | queens))
+        return true;
+    if (bishopAttacks(sq, occupiedAll) & (pieces[by][PT_BISHOP] | queens))
+        return true;
 
-        if (isEmpty(newX, newY) || isEnemy(newX, newY, isWhite)) {
-            moves.emplace_back(x, y, newX, newY);
-        }
-    }
+    return false;
 }
 
-void Board::generateKingMoves(int x,
-                              int y,
-                              bool isWhite,
-                              std::vector<Move> &moves) const
+MoveList Board::generateAllMoves(bool isWhite) const
 {
-    // Обычные ходы короля (1 клетка в любом направлении)
-    constexpr std::array<std::pair<int, int>, 8> kingOffsets = {
-        {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}}
-    };
+    MoveList moves;
+    generateMoves(isWhite, GEN_ALL, moves);
+    return moves;
+}
 
-    for (const auto &[dx, dy] : kingOffsets) {
-        const int newX = x + dx;
-        const int newY = y + dy;
+MoveList Board::generateCaptures(bool isWhite) const
+{
+    MoveList moves;
+    generateMoves(isWhite, GEN_CAPTURES, moves);
+    return moves;
+}
 
-        if (isInBounds(newX, newY) && !isAlly(newX, newY, isWhite)) {
-            moves.emplace_back(x, y, newX, newY);
-        }
+bool Board::isLegal(const Move &move) const
+{
+    // Генерируем ходы одной фигуры, а не всей позиции
+    const int from = move.from();
+    if (!move.isValid() || !(occupied[whiteToMove ? WHITE : BLACK] & squareBB(from))) {
+        return false;
     }
 
-    if (!hasKingMoved(isWhite)) {
-        if (canCastleKingside(isWhite)) {
-            moves.emplace_back(x, y, x, y + 2);
-        }
-
-        if (canCastleQueenside(isWhite)) {
-            moves.emplace_back(x, y, x, y - 2);
-        }
-    }
+    MoveList moves;
+    generateMoves(whiteToMove, GEN_ALL, moves, squareBB(from));
+    return std::find(moves.begin(), moves.end(), move) != moves.end();
 }
 
-void Board::generateQueenMoves(int x,
-                               int y,
-                               bool isWhite,
-                               std::vector<Move> &moves) const
+void Board::generateMoves(bool isWhite,
+                          GenType type,
+                          MoveList &moves,
+                          Bitboard fromMask) const
 {
-    generateRookMoves(x, y, isWhite, moves);
-    generateBishopMoves(x, y, isWhite, moves);
-}
+    SEARCH_TIMER(TIMER_MOVEGEN);
+
+    const Color us = isWhite ? WHITE : BLACK;
+    const Color them = isWhite ? BLACK : WHITE;
+    const int king = kingSquare(us);
+
+    // Шахующие фигуры, связки и битые поля считаются один раз на позицию
+    Bitboard checkers = 0;
+    if (king >= 0) {
+        checkers = attackersTo(king, occupiedAll) & occupied[them];
+        if (fromMask & squareBB(king)) {
+            const Bitboard danger =
+                attackedSquares(them, occupiedAll ^ squareBB(king));
+            generateKingMoves(king, isWhite, danger, checkers != 0, type, moves);
+        }
 
-bool Board::isSquareUnderAttack(int x, int y, bool byWhite) const
-{
-    // Проверяем атаку пешками
-    int pawnDir = byWhite ? -1 : 1;
-    for (int dy : {-1, 1}) {
-        if (isInBounds(x + pawnDir, y + dy)) {
-            char piece = board[x + pawnDir][y + dy];
-            if ((byWhite && piece == 'P') || (!byWhite && piece == 'p')) {
-                return true;
-            }
+        // При двойном шахе ходит только король
+        if (checkers & (checkers - 1)) {
+            return;
         }
     }
 
-    // Проверяем атаку конями
-    constexpr std::array<std::pair<int, int>, 8> knightMoves = {
-        {{2, 1},
-         {2, -1},
-         {-2, 1},
-         {-2, -1},
-         {1, 2},
-         {1, -2},
-         {-1, 2},
-         {-1, -2}}
-    };
-    for (const auto &[dx, dy] : knightMoves) {
-        int nx = x + dx;
-        int ny = y + dy;
-        if (isInBounds(nx, ny)) {
-            char piece = board[nx][ny];
-            char neededKnight = byWhite ? 'N' : 'n';
-            if (toupper(piece) == 'N' && piece == neededKnight) {
-                return true;
-            }
-        }
+    // Без шаха можно ходить куда угодно, при шахе - бить или закрываться
+    const Bitboard checkMask =
+        checkers ? BetweenBB[king][lsb(checkers)] | checkers : ~0ULL;
+    const Bitboard pinned = pinnedPieces(us);
+    const Bitboard targets = (type == GEN_CAPTURES ? occupied[them]
+                              : type == GEN_QUIETS ? ~occupiedAll
+                                                   : ~occupied[us]) &
+                             checkMask;
+
+    Bitboard bb = pieces[us][PT_PAWN] & fromMask;
+    while (bb) {
+        const int from = popLsb(bb);
+        const Bitboard pinMask =
+            (pinned & squareBB(from)) ? LineBB[king][from] : ~0ULL;
+        generatePawnMoves(from, isWhite, checkMask & pinMask, type, moves);
     }
 
-    // Проверяем атаку по прямым (ладьи, ферзи)
-    constexpr std::array<std::pair<int, int>, 4> rookDirections = {
-        {{1, 0}, {-1, 0}, {0, 1}, {0, -1}}
-    };
-    for (const auto &[dx, dy] : rookDirections) {
-        for (int step = 1; step < 8; ++step) {
-            int nx = x + dx * step;
-            int ny = y + dy * step;
-            if (!isInBounds(nx, ny)) {
-                break;
-            }
+    // Связанный конь не может сойти с линии связки
+    bb = pieces[us][PT_KNIGHT] & ~pinned & fromMask;
+    while (bb) {
+        const int from = popLsb(bb);
+        generatePieceMoves(from, KnightAttacks[from] & targets, moves);
+    }
 
-            char piece = board[nx][ny];
-            if (piece != EMPTY) {
-                char neededRook = byWhite ? 'R' : 'r';
-                char neededQueen = byWhite ? 'Q' : 'q';
-                if (piece == neededRook || piece == neededQueen) {
-                    return true;
-                }
-                break;
+    for (const PieceType piece : {PT_BISHOP, PT_ROOK, PT_QUEEN}) {
+        bb = pieces[us][piece] & fromMask;
+        while (bb) {
+            const int from = popLsb(bb);
+            Bitboard attacks = piece == PT_BISHOP ? bishopAttacks(from, occupiedAll)
+                               : piece == PT_ROOK ? rookAttacks(from, occupiedAll)
+                                                  : queenAttacks(from, occupiedAll);
+            if (pinned & squareBB(from)) {
+                attacks &= LineBB[king][from];
             }
+            generatePieceMoves(from, attacks & targets, moves);
         }
     }
+}
 
-    // Проверяем атаку по диагоналям (слоны, ферзи)
-    constexpr std::array<std::pair<int, int>, 4> bishopDirections = {
-        {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}
-    };
-    for (const auto &[dx, dy] : bishopDirections) {
-        for (int step = 1; step < 8; ++step) {
-            int nx = x + dx * step;
-            int ny = y + dy * step;
-            if (!isInBounds(nx, ny))
-                break;
+int Board::see(const Move &move) const
+{
+    constexpr int seeValues[6] = {100, 320, 330, 500, 900, 20000};
 
-            char piece = board[nx][ny];
-            if (piece != EMPTY) {
-                char neededBishop = byWhite ? 'B' : 'b';
-                char neededQueen = byWhite ? 'Q' : 'q';
-                if (piece == neededBishop || piece == neededQueen) {
-                    return true;
-                }
-                break;
-            }
-        }
+    if (move.isCastle()) {
+        return 0;
     }
 
-    // Проверяем атаку королем
-    constexpr std::array<std::pair<int, int>, 8> kingMoves = {
-        {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}}
-    };
-    for (const auto &[dx, dy] : kingMoves) {
-        int nx = x + dx;
-        int ny = y + dy;
-        if (isInBounds(nx, ny)) {
-            char piece = board[nx][ny];
-            char neededKing = byWhite ? 'K' : 'k';
-            if (piece == neededKing) {
-                return true;
-            }
-        }
+    const int from = move.from();
+    const int to = move.to();
+    const Color side = occupied[WHITE] & squareBB(from) ? WHITE : BLACK;
+
+    // Обмен на поле хода: каждый раз бьёт самая дешёвая фигура очередной
+    // стороны, открывшиеся за ней дальнобойные фигуры добавляются
+    int gain[32];
+    int depth = 0;
+
+    Bitboard occ = occupiedAll ^ squareBB(from);
+    if (move.flags() == Move::EN_PASSANT) {
+        gain[0] = seeValues[PT_PAWN];
+        occ ^= squareBB(makeSquare(squareX(from), squareY(to)));
+    } else {
+        const char target = board[squareX(to)][squareY(to)];
+        gain[0] = target != EMPTY ? seeValues[pieceTypeOf(target)] : 0;
     }
 
-    return false;
-}
+    PieceType attacker = pieceTypeOf(board[squareX(from)][squareY(from)]);
+    if (move.isPromotion()) {
+        attacker = move.promotionType();
+        gain[0] += seeValues[attacker] - seeValues[PT_PAWN];
+    }
 
-std::vector<Move> Board::generateAllMoves(bool isWhite) const
-{
-    std::vector<Move> moves;
-    moves.reserve(100);
+    const Bitboard diagonal = pieces[WHITE][PT_BISHOP] | pieces[BLACK][PT_BISHOP] |
+                              pieces[WHITE][PT_QUEEN] | pieces[BLACK][PT_QUEEN];
+    const Bitboard straight = pieces[WHITE][PT_ROOK] | pieces[BLACK][PT_ROOK] |
+                              pieces[WHITE][PT_QUEEN] | pieces[BLACK][PT_QUEEN];
 
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if ((isWhite && isupper(board[i][j])) ||
-                (!isWhite && islower(board[i][j]))) {
-                switch (toupper(board[i][j])) {
-                case PAWN:
-                    generatePawnMoves(i, j, isWhite, moves);
-                    break;
-                case KNIGHT:
-                    generateKnightMoves(i, j, isWhite, moves);
-                    break;
-                case BISHOP:
-                    generateBishopMoves(i, j, isWhite, moves);
-                    break;
-                case ROOK:
-                    generateRookMoves(i, j, isWhite, moves);
-                    break;
-                case QUEEN:
-                    generateQueenMoves(i, j, isWhite, moves);
-                    break;
-                case KING:
-                    generateKingMoves(i, j, isWhite, moves);
-                    break;
-                }
-            }
-        }
-    }
+    Bitboard attackers = attackersTo(to, occ) & occ;
+    Color turn = side == WHITE ? BLACK : WHITE;
 
-    std::vector<Move> validMoves;
-    for (const Move &move : moves) {
-        Board tempBoard = *this;
+    while (depth < 31) {
+        ++depth;
+        gain[depth] = seeValues[attacker] - gain[depth - 1];
+        if (std::max(-gain[depth - 1], gain[depth]) < 0) {
+            break;
+        }
 
-        char movingPiece = tempBoard.board[move.fromX][move.fromY];
-        tempBoard.board[move.toX][move.toY] = movingPiece;
-        tempBoard.board[move.fromX][move.fromY] = EMPTY;
+        const Bitboard own = attackers & occupied[turn];
+        if (!own) {
+            break;
+        }
 
-        if (!tempBoard.isCheck(isWhite)) {
-            validMoves.push_back(move);
+        int sq = -1;
+        for (int type = PT_PAWN; type <= PT_KING; ++type) {
+            const Bitboard bb = own & pieces[turn][type];
+            if (bb) {
+                sq = lsb(bb);
+                attacker = static_cast<PieceType>(type);
+                break;
+            }
         }
-    }
 
-    // Проверка ходов
-    // for (Move move : validMoves){
-    //     std::cout << move << "; ";
-    // }
-    // std::cout << "\n";
+        occ ^= squareBB(sq);
+        attackers |= (bishopAttacks(to, occ) & diagonal) |
+                     (rookAttacks(to, occ) & straight);
+        attackers &= occ;
+        turn = turn == WHITE ? BLACK : WHITE;
+    }
 
-    return validMoves;
-}
\ No newline at end of file
+    while (--depth) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    }
+    return gain[0];
+}
@@ -1,233 +1,847 @@
 #include "../include/Engine.h"
+#include "../include/MovePicker.h"
+#include "../include/Psqt.h"
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <limits>
-#include <unordered_map>
+#include <iterator>
+#include <thread>
 
 Move ChessEngine::findBestMove(Board &board, bool isWhite, int depth)
 {
-    if (board.isCheck(!isWhite))
-        depth += 1;
+    // Поиск всегда идёт за сторону, чей ход на доске
+    assert(isWhite == board.isWhiteToMove());
+    (void)isWhite;
+    SearchLimits depthOnly;
+    depthOnly.maxDepth = depth;
+    return findBestMove(board, depthOnly);
+}
 
-    std::vector<Move> moves = board.generateAllMoves(isWhite);
-    if (moves.empty())
-        return Move(-1, -1, -1, -1);
+Move ChessEngine::findBestMove(Board &board, const SearchLimits &searchLimits)
+{
+    return search(board, searchLimits).bestMove;
+}
 
-    for (const Move &move : moves) {
-        Board tempBoard = board;
-        if (tempBoard.makeMove(move) && tempBoard.isCheckmate(!isWhite)) {
-            return move;
-        }
+SearchResult ChessEngine::search(Board &board, const SearchLimits &searchLimits)
+{
+    prepareSearch(searchLimits);
+    return runSearch(board);
+}
+
+void ChessEngine::startSearch(const Board &board,
+                              const SearchLimits &searchLimits)
+{
+    waitSearch();
+
+    // Флаги сбрасываются до запуска потока, поэтому stop() и ponderHit(),
+    // пришедшие сразу после startSearch(), не потеряются
+    prepareSearch(searchLimits);
+    asyncBoard = board;
+    searchWorker = std::thread([this] { asyncResult = runSearch(asyncBoard); });
+}
+
+SearchResult ChessEngine::waitSearch()
+{
+    if (searchWorker.joinable()) {
+        searchWorker.join();
+    }
+    return asyncResult;
+}
+
+void ChessEngine::prepareSearch(const SearchLimits &searchLimits)
+{
+    limits = searchLimits;
+    // Как и у остальных полей, 0 - без ограничения глубины
+    if (limits.maxDepth <= 0)
+        limits.maxDepth = SearchLimits().maxDepth;
+    nextReportMs = 1000;
+    stopped = false;
+    pondering = limits.ponder;
+    searchStart = std::chrono::steady_clock::now();
+    startTicks = searchStart.time_since_epoch().count();
+}
+
+SearchResult ChessEngine::runSearch(Board &board)
+{
+    // Ходы корня и шах считаются один раз; под шахом ищем на ход глубже
+    const NodeStatus status = board.nodeStatus(board.isWhiteToMove());
+    lastStats.clear();
+    if (status.moves.empty())
+        return SearchResult();
+
+    const Move bookMove =
+        book.isOpen() ? book.pickMove(board, bookRandom) : Move();
+    if (bookMove.isValid()) {
+        SearchResult result;
+        result.bestMove = bookMove;
+        result.pv.push_back(bookMove);
+        return result;
     }
 
-    Move bestMove = moves[0];
-    int bestValue = isWhite ? std::numeric_limits<int>::min()
-                            : std::numeric_limits<int>::max();
+    SearchResult tablebaseResult;
+    if (probeRoot(board, status.moves, tablebaseResult))
+        return tablebaseResult;
 
-    std::vector<Move> orderedMoves = orderMoves(board, moves);
+    if (status.inCheck)
+        limits.maxDepth += 1;
 
-    for (const Move &move : orderedMoves) {
-        Board tempBoard = board;
-        if (!tempBoard.makeMove(move))
-            continue;
+    tt.newSearch();
 
-        if (tempBoard.isStalemate(!isWhite)) {
-            continue;
+    for (auto &thread : threads) {
+        thread->clearHeuristics();
+    }
+
+    // Корневые ходы упорядочиваем один раз тем же сборщиком, что и в узлах
+    MoveList rootMoves;
+    MovePicker picker(board, Move(), nullptr, Move(), threads[0]->history);
+    for (Move move = picker.next(); move.isValid(); move = picker.next()) {
+        rootMoves.add(move);
+    }
+
+    for (auto &thread : threads) {
+        thread->board = board;
+        thread->rootMoves = rootMoves;
+        thread->result = SearchResult();
+        thread->result.bestMove = rootMoves[0];
+        thread->rootDepth = 0;
+        thread->nodes = 0;
+        thread->stats.clear();
+    }
+
+    // Lazy SMP: помощники ищут тот же корень независимо и делятся
+    // результатами только через общую таблицу перестановок
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < threads.size(); ++i) {
+        helpers.emplace_back(
+            [this, &thread = *threads[i]] { iterativeDeepening(thread); });
+    }
+
+    iterativeDeepening(*threads[0]);
+
+    stopped = true;
+    for (std::thread &helper : helpers) {
+        helper.join();
+    }
+
+    for (auto &thread : threads) {
+        thread->stats.nodes = thread->nodes;
+        thread->stats.threads = 1;
+        lastStats.merge(thread->stats);
+    }
+    lastStats.timeMs = searchTimeMs();
+
+    return threads[0]->result;
+}
+
+void ChessEngine::iterativeDeepening(SearchThread &thread)
+{
+    // Нечётные помощники начинают на ход глубже, а корневые ходы у каждого
+    // помощника сдвинуты, чтобы потоки расходились по разным поддеревьям
+    const int startDepth = thread.id == 0 ? 1 : 1 + (thread.id & 1);
+    if (thread.id > 0 && thread.rootMoves.size() > 1) {
+        const int shift = thread.id % thread.rootMoves.size();
+        std::rotate(thread.rootMoves.begin(),
+                    thread.rootMoves.begin() + shift,
+                    thread.rootMoves.end());
+    }
+
+    resetSearchTimers();
+    int previousScore = 0;
+    for (thread.rootDepth = startDepth; thread.rootDepth <= limits.maxDepth;
+         ++thread.rootDepth) {
+        const int depth = thread.rootDepth;
+
+        // Окно вокруг оценки прошлой итерации; при выходе за него
+        // расширяем окно в ту сторону и повторяем поиск
+        int delta = 25;
+        int alpha = -INF_SCORE;
+        int beta = INF_SCORE;
+        if (depth >= 5 && std::abs(previousScore) < MATE_BOUND) {
+            alpha = std::max(previousScore - delta, -INF_SCORE);
+            beta = std::min(previousScore + delta, INF_SCORE);
         }
 
-        int moveValue = minimax(tempBoard,
-                                depth - 1,
-                                std::numeric_limits<int>::min(),
-                                std::numeric_limits<int>::max(),
-                                !isWhite);
+        Move iterationMove;
+        int value;
+        for (;;) {
+            iterationMove = Move();
+            value = searchRoot(thread, depth, alpha, beta, iterationMove);
+            if (stopped)
+                break;
 
-        if (isWhite) {
-            if (moveValue > bestValue) {
-                bestValue = moveValue;
-                bestMove = move;
+            if (value <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(value - delta, -INF_SCORE);
+            } else if (value >= beta) {
+                beta = std::min(value + delta, INF_SCORE);
+            } else {
+                break;
             }
+            delta *= 2;
+        }
+
+        // Прерванная итерация не в счёт: ход берём из последней полной
+        if (stopped)
+            break;
+
+        if (iterationMove.isValid()) {
+            previousScore = value;
+            thread.result.bestMove = iterationMove;
+            thread.result.score = value;
+            thread.result.depth = depth;
+            thread.result.pv.assign(thread.pv[0], thread.pv[0] + thread.pvLength[0]);
+            tt.store(thread.board.getHash(), depth, value, TT_EXACT, iterationMove);
+
+            if (thread.id == 0)
+                thread.stats.depths.push_back(
+                    {depth, value, totalNodes(), searchTimeMs()});
+
+            if (thread.id == 0 && infoCallback) {
+                SearchInfo info;
+                info.depth = depth;
+                info.score = value;
+                info.nodes = totalNodes();
+                info.timeMs = searchTimeMs();
+                info.hashfull = tt.hashfull();
+                info.pv = thread.result.pv;
+                infoCallback(info);
+            }
+
+            // Лучший ход итерации перебираем первым на следующей
+            auto it = std::find(thread.rootMoves.begin(),
+                                thread.rootMoves.end(),
+                                iterationMove);
+            std::rotate(thread.rootMoves.begin(), it, it + 1);
+        }
+
+        // Мат в пределах глубины итерации найден точно, искать глубже незачем
+        if (thread.id == 0 && iterationMove.isValid() && value >= MATE_BOUND &&
+            MATE_SCORE - value <= depth)
+            break;
+
+        // Следующая итерация обычно дольше всех предыдущих вместе взятых
+        if (thread.id == 0 && !pondering && limits.maxTimeMs > 0 &&
+            elapsedMs() * 2 >= limits.maxTimeMs)
+            break;
+    }
+
+    collectSearchTimers(thread.stats);
+}
+
+int ChessEngine::searchRoot(
+    SearchThread &thread, int depth, int alpha, int beta, Move &bestMove)
+{
+    Board &board = thread.board;
+    int bestValue = -INF_SCORE;
+    int moveCount = 0;
+    thread.pvLength[0] = 0;
+
+    for (const Move &move : thread.rootMoves) {
+        UndoInfo undo;
+        board.doMove(move, undo);
+        thread.moveStack[0] = move;
+        ++moveCount;
+
+        // Первый ход - с полным окном, остальные лишь проверяем на улучшение
+        int value;
+        if (moveCount == 1 || !options.pvs) {
+            value = -negamax(thread, depth - 1, 1, -beta, -alpha, true);
         } else {
-            if (moveValue < bestValue) {
-                bestValue = moveValue;
+            value = -negamax(thread, depth - 1, 1, -alpha - 1, -alpha, true);
+            if (value > alpha && value < beta)
+                value = -negamax(thread, depth - 1, 1, -beta, -alpha, true);
+        }
+        board.undoMove(move, undo);
+
+        if (stopped)
+            break;
+
+        if (value > bestValue) {
+            bestValue = value;
+            if (value > alpha) {
+                alpha = value;
                 bestMove = move;
+                updatePv(thread, 0, move);
+                if (alpha >= beta)
+                    break;
             }
         }
     }
 
-    if (bestValue == (isWhite ? std::numeric_limits<int>::min()
-                              : std::numeric_limits<int>::max())) {
-        return moves[0];
+    return bestValue;
+}
+
+bool ChessEngine::probeRoot(Board &board,
+                            const MoveList &moves,
+                            SearchResult &result)
+{
+    TbResult root;
+    if (tablebases.empty() || !tablebases.probe(board, root))
+        return false;
+
+    // Выигрывая, идём к самому быстрому мату, проигрывая - к самому
+    // долгому; в ничьей годится любой ход, сохраняющий ничью
+    Move best;
+    int bestScore = -INF_SCORE;
+    for (const Move &move : moves) {
+        UndoInfo undo;
+        board.doMove(move, undo);
+        TbResult child;
+        const bool found = tablebases.probe(board, child);
+        board.undoMove(move, undo);
+        if (!found)
+            return false;
+
+        int score = 0;
+        if (child.wdl < 0)
+            score = MATE_SCORE - (child.dtm + 1);
+        else if (child.wdl > 0)
+            score = -MATE_SCORE + child.dtm + 1;
+        if (score > bestScore) {
+            bestScore = score;
+            best = move;
+        }
     }
 
-    return bestMove;
+    result.bestMove = best;
+    result.score = bestScore;
+    result.depth = 1;
+    result.pv.push_back(best);
+    lastStats.tbHits = static_cast<uint64_t>(moves.size()) + 1;
+
+    if (infoCallback) {
+        SearchInfo info;
+        info.depth = result.depth;
+        info.score = result.score;
+        info.pv = result.pv;
+        infoCallback(info);
+    }
+    return true;
 }
 
-int ChessEngine::minimax(
-    Board &board, int depth, int alpha, int beta, bool maximizingPlayer)
+void ChessEngine::updatePv(SearchThread &thread, int ply, const Move &move)
 {
-    if (board.isCheckmate(!maximizingPlayer)) {
-        return maximizingPlayer ? std::numeric_limits<int>::max() / 2
-                                : std::numeric_limits<int>::min() / 2;
+    // Вариант узла - его ход плюс вариант ответа из следующего ply
+    thread.pv[ply][0] = move;
+    const int childLength = ply + 1 < MAX_PLY ? thread.pvLength[ply + 1] : 0;
+    for (int i = 0; i < childLength; ++i) {
+        thread.pv[ply][i + 1] = thread.pv[ply + 1][i];
     }
+    thread.pvLength[ply] = childLength + 1;
+}
+
+int64_t ChessEngine::elapsedMs() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() -
+               std::chrono::steady_clock::time_point(
+                   std::chrono::steady_clock::duration(startTicks.load())))
+        .count();
+}
 
-    if (depth == 0 || board.isStalemate(!maximizingPlayer)) {
-        return evaluateBoard(board);
+int64_t ChessEngine::searchTimeMs() const
+{
+    // В отличие от elapsedMs() не сбрасывается при ponderHit()
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - searchStart)
+        .count();
+}
+
+uint64_t ChessEngine::totalNodes() const
+{
+    uint64_t total = 0;
+    for (const auto &thread : threads) {
+        total += thread->nodes.load(std::memory_order_relaxed);
     }
+    return total;
+}
 
-    std::vector<Move> moves = board.generateAllMoves(maximizingPlayer);
-    moves = orderMoves(board, moves);
+bool ChessEngine::checkLimits(SearchThread &thread)
+{
+    // Лимиты проверяет только главный поток, помощники лишь следят за флагом
+    if (stopped || thread.id != 0)
+        return stopped;
+
+    const uint64_t nodes = thread.nodes.load(std::memory_order_relaxed);
+    const bool timeCheck = (nodes & 1023) == 0;
+
+    // Долгие итерации не должны выглядеть как зависание: раз в секунду
+    // сообщаем хотя бы число узлов
+    if (timeCheck && infoCallback && searchTimeMs() >= nextReportMs) {
+        SearchInfo info;
+        info.depth = thread.rootDepth;
+        info.nodes = totalNodes();
+        info.timeMs = searchTimeMs();
+        info.hashfull = tt.hashfull();
+        infoCallback(info);
+        nextReportMs = info.timeMs + 1000;
+    }
 
-    if (maximizingPlayer) {
-        int maxEval = std::numeric_limits<int>::min();
-        for (const Move &move : moves) {
-            Board tempBoard = board;
-            if (!tempBoard.makeMove(move))
-                continue;
+    // Первая итерация доходит до конца всегда, чтобы был хоть какой-то ход
+    if (pondering || thread.rootDepth <= 1)
+        return false;
 
-            if (tempBoard.isStalemate(!maximizingPlayer))
-                continue;
+    if (limits.maxNodes > 0 && totalNodes() >= limits.maxNodes)
+        stopped = true;
+    else if (limits.maxTimeMs > 0 && timeCheck &&
+             elapsedMs() >= limits.maxTimeMs)
+        stopped = true;
 
-            int eval = minimax(tempBoard, depth - 1, alpha, beta, false);
-            maxEval = std::max(maxEval, eval);
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha)
-                break;
-        }
-        return maxEval != std::numeric_limits<int>::min() ? maxEval : 0;
-    } else {
-        int minEval = std::numeric_limits<int>::max();
-        for (const Move &move : moves) {
-            Board tempBoard = board;
-            if (!tempBoard.makeMove(move))
-                continue;
+    return stopped;
+}
 
-            if (tempBoard.isStalemate(!maximizingPlayer))
-                continue;
+namespace {
 
-            int eval = minimax(tempBoard, depth - 1, alpha, beta, true);
-            minEval = std::min(minEval, eval);
-            beta = std::min(beta, eval);
-            if (beta <= alpha)
-                break;
+constexpr int HISTORY_MAX = 16384;
+constexpr int FUTILITY_DEPTH = 3;
+constexpr int FutilityMargin[FUTILITY_DEPTH + 1] = {0, 200, 350, 500};
+
+void addHistory(int &value, int bonus)
+{
+    // Значение плавно насыщается у ±HISTORY_MAX
+    value += bonus - value * std::abs(bonus) / HISTORY_MAX;
+}
+
+// Сокращение растёт логарифмически и по глубине, и по номеру хода
+int lmrReduction(int depth, int moveCount)
+{
+    static const auto table = [] {
+        std::array<std::array<int, 64>, 64> reductions{};
+        for (int d = 1; d < 64; ++d) {
+            for (int m = 1; m < 64; ++m) {
+                reductions[d][m] =
+                    static_cast<int>(0.75 + std::log(d) * std::log(m) / 2.25);
+            }
         }
-        return minEval != std::numeric_limits<int>::max() ? minEval : 0;
+        return reductions;
+    }();
+    return table[std::min(depth, 63)][std::min(moveCount, 63)];
+}
+
+// Маты в таблице хранятся относительно узла, а не корня
+int scoreToTT(int score, int ply)
+{
+    if (score >= MATE_BOUND)
+        return score + ply;
+    if (score <= -MATE_BOUND)
+        return score - ply;
+    return score;
+}
+
+int scoreFromTT(int score, int ply)
+{
+    if (score >= MATE_BOUND)
+        return score - ply;
+    if (score <= -MATE_BOUND)
+        return score + ply;
+    return score;
+}
+
+} // namespace
+
+void ChessEngine::stop()
+{
+    stopped = true;
+}
+
+void ChessEngine::ponderHit()
+{
+    // Соперник сыграл ожидаемый ход: поиск продолжается, но теперь уже
+    // в обычных лимитах, отсчитанных с этого момента
+    startTicks = std::chrono::steady_clock::now().time_since_epoch().count();
+    pondering = false;
+}
+
+ChessEngine::ChessEngine(size_t hashMegabytes) : tt(hashMegabytes)
+{
+    setThreads(1);
+}
+
+ChessEngine::~ChessEngine()
+{
+    stop();
+    waitSearch();
+}
+
+void ChessEngine::setThreads(int count)
+{
+    threads.clear();
+    for (int i = 0; i < std::max(count, 1); ++i) {
+        threads.push_back(std::make_unique<SearchThread>());
+        threads.back()->id = i;
     }
 }
 
-int ChessEngine::evaluateBoard(const Board &board)
+int ChessEngine::setTablebasePath(const std::string &directory)
 {
-    if (board.isCheckmate(true))
-        return std::numeric_limits<int>::min() + 1;
-    if (board.isCheckmate(false))
-        return std::numeric_limits<int>::max() - 1;
-    if (board.isStalemate(true) || board.isStalemate(false))
-        return 0;
+    tablebases.clear();
+    return directory.empty() ? 0 : tablebases.load(directory);
+}
 
-    int score = 0;
-
-    const std::unordered_map<char, int> pieceValues = {
-        {'P', 100   },
-        {'N', 320   },
-        {'B', 330   },
-        {'R', 500   },
-        {'Q', 900   },
-        {'K', 20000 },
-        {'p', -100  },
-        {'n', -320  },
-        {'b', -330  },
-        {'r', -500  },
-        {'q', -900  },
-        {'k', -20000},
-        {'.', 0     }
-    };
-
-    const int centerControl[8][8] = {
-        {0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 1, 2, 3, 3, 2, 1, 0},
-        {0, 2, 4, 6, 6, 4, 2, 0},
-        {0, 3, 6, 9, 9, 6, 3, 0},
-        {0, 3, 6, 9, 9, 6, 3, 0},
-        {0, 2, 4, 6, 6, 4, 2, 0},
-        {0, 1, 2, 3, 3, 2, 1, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0}
-    };
-
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            char piece = board.board[i][j];
-            score += pieceValues.at(piece) / 10;
-
-            if (isupper(piece))
-                score += centerControl[i][j];
-            else if (islower(piece))
-                score -= centerControl[i][j];
-        }
-    }
-
-    if (board.isCheck(true))
-        score -= 50;
-    if (board.isCheck(false))
-        score += 50;
-
-    int whiteMobility = board.generateAllMoves(true).size();
-    int blackMobility = board.generateAllMoves(false).size();
-    score += (whiteMobility - blackMobility);
+bool ChessEngine::setBookFile(const std::string &path)
+{
+    if (path.empty()) {
+        book.close();
+        return true;
+    }
+    return book.open(path);
+}
 
-    return score;
+void ChessEngine::setHashSize(size_t megabytes)
+{
+    tt.resize(megabytes);
 }
 
-std::vector<Move> ChessEngine::orderMoves(const Board &board,
-                                          const std::vector<Move> &moves)
+void ChessEngine::clearHash()
 {
-    std::vector<std::pair<int, Move>> scoredMoves;
+    // Вместе с таблицей забываем и историю: после очистки поиск идёт так же,
+    // как у только что созданного движка
+    tt.clear();
+    for (auto &thread : threads) {
+        for (auto &side : thread->history) {
+            for (auto &row : side) {
+                std::fill(std::begin(row), std::end(row), 0);
+            }
+        }
+    }
+}
 
-    for (const Move &move : moves) {
+int ChessEngine::negamax(SearchThread &thread,
+                         int depth,
+                         int ply,
+                         int alpha,
+                         int beta,
+                         bool allowNull)
+{
+    if (ply < MAX_PLY)
+        thread.pvLength[ply] = 0;
+    if (depth <= 0 || ply >= MAX_PLY)
+        return quiescence(thread, ply, alpha, beta);
+
+    // Счётчик пишет только свой поток, так что хватает обычного инкремента
+    thread.nodes.store(thread.nodes.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+    if (checkLimits(thread))
+        return 0;
+
+    Board &board = thread.board;
+    const bool pvNode = beta - alpha > 1;
+    const int alphaOrig = alpha;
+    const uint64_t key = board.getHash();
+    const Color us = board.isWhiteToMove() ? WHITE : BLACK;
+
+    Move ttMove;
+    TTEntry entry;
+    ++thread.stats.ttProbes;
+    if (tt.probe(key, entry)) {
+        ++thread.stats.ttHits;
+        ttMove = entry.bestMove;
+        const int ttScore = scoreFromTT(entry.score, ply);
+        // В узлах главного варианта не отсекаем, чтобы вариант не обрывался
+        if (!pvNode && entry.depth >= depth) {
+            if (entry.bound() == TT_EXACT)
+                return ttScore;
+            if (entry.bound() == TT_LOWER && ttScore >= beta)
+                return ttScore;
+            if (entry.bound() == TT_UPPER && ttScore <= alpha)
+                return ttScore;
+        }
+    }
+
+    // В таблицах эндшпиля оценка точная: мат с известным числом полуходов
+    // или ничья. Для матов ply отсчитывается от корня, как и в поиске
+    TbResult tbResult;
+    if (popCount(board.getOccupancy()) <= tablebases.maxPieces() &&
+        tablebases.probe(board, tbResult)) {
+        ++thread.stats.tbHits;
         int score = 0;
-        char targetPiece = board.board[move.toX][move.toY];
+        if (tbResult.wdl != 0) {
+            const int distance = std::min(ply + tbResult.dtm, MAX_PLY - 1);
+            score = tbResult.wdl > 0 ? MATE_SCORE - distance
+                                     : -MATE_SCORE + distance;
+        }
+        tt.store(key, depth, scoreToTT(score, ply), TT_EXACT, Move());
+        return score;
+    }
+
+    const bool inCheck = board.isCheck(us == WHITE);
+    const int staticEval = inCheck ? -INF_SCORE : evaluate(board);
+
+    // Пропуск хода: если и после него соперник не дотягивает до beta,
+    // позиция достаточно хороша. В пешечных окончаниях пропуск хода бывает
+    // лучше любого хода (цугцванг), поэтому там не применяем
+    const Bitboard nonPawn = board.getOccupancy(us) &
+                             ~board.getPieces(us, PT_PAWN) &
+                             ~board.getPieces(us, PT_KING);
+    if (options.nullMove && allowNull && !pvNode && !inCheck && depth >= 3 &&
+        staticEval >= beta && nonPawn) {
+        const int reduction =
+            3 + depth / 6 + std::min((staticEval - beta) / 200, 2);
+
+        UndoInfo undo;
+        board.doNullMove(undo);
+        thread.moveStack[ply] = Move();
+        const int value = -negamax(
+            thread, depth - 1 - reduction, ply + 1, -beta, -beta + 1, false);
+        board.undoNullMove(undo);
+        if (stopped)
+            return 0;
+
+        if (value >= beta)
+            return value >= MATE_BOUND ? beta : value;
+    }
 
-        // Приоритет взятий (MVV-LVA)
-        if (targetPiece != EMPTY) {
-            const std::unordered_map<char, int> pieceValues = {
-                {'P', 100  },
-                {'N', 320  },
-                {'B', 330  },
-                {'R', 500  },
-                {'Q', 900  },
-                {'K', 20000},
-                {'p', 100  },
-                {'n', 320  },
-                {'b', 330  },
-                {'r', 500  },
-                {'q', 900  },
-                {'k', 20000},
-                {'.', 0    }
-            };
-            char movingPiece = board.board[move.fromX][move.fromY];
-            score =
-                10 * pieceValues.at(targetPiece) - pieceValues.at(movingPiece);
+    // У листьев тихий ход не поднимет оценку выше alpha, если до неё
+    // не хватает больше запаса на позиционные изменения
+    const bool futile = options.futility && !pvNode && !inCheck &&
+                        depth <= FUTILITY_DEPTH &&
+                        staticEval + FutilityMargin[depth] <= alpha;
+
+    const Move &previous = thread.moveStack[ply - 1];
+    MovePicker picker(board,
+                      ttMove,
+                      thread.killers[ply],
+                      thread.counterMoves[previous.from()][previous.to()],
+                      thread.history);
+
+    Move bestMove;
+    int bestValue = -INF_SCORE;
+    int moveCount = 0;
+    Move quietsTried[MoveList::MAX_MOVES];
+    int quietCount = 0;
+
+    for (Move move = picker.next(); move.isValid(); move = picker.next()) {
+        const bool quiet = !move.isCapture() && !move.isPromotion();
+
+        UndoInfo undo;
+        board.doMove(move, undo);
+        const bool givesCheck = board.isCheck(us != WHITE);
+        ++moveCount;
+
+        if (futile && quiet && !givesCheck && moveCount > 1) {
+            board.undoMove(move, undo);
+            continue;
+        }
+        thread.moveStack[ply] = move;
+
+        // Поздние тихие ходы сначала ищем мельче; удачная история сокращает
+        // меньше. Если ход всё же улучшает alpha, перепроверяем полностью
+        int reduction = 0;
+        if (options.lmr && depth >= 3 && moveCount > 3 && quiet && !inCheck &&
+            !givesCheck) {
+            reduction = lmrReduction(depth, moveCount);
+            reduction -= thread.history[us][move.from()][move.to()] / 8192;
+            if (pvNode)
+                --reduction;
+            reduction = std::clamp(reduction, 0, depth - 2);
         }
 
-        Board tempBoard = board;
-        tempBoard.makeMove(move);
-        if (tempBoard.isCheck(!board.isWhite(move.fromX, move.fromY))) {
-            score += 1000;
+        int value = 0;
+        if (options.pvs) {
+            bool fullDepth = !pvNode || moveCount > 1;
+            if (reduction > 0) {
+                value = -negamax(thread,
+                                 depth - 1 - reduction,
+                                 ply + 1,
+                                 -alpha - 1,
+                                 -alpha,
+                                 true);
+                fullDepth = value > alpha;
+            }
+            if (fullDepth)
+                value = -negamax(
+                    thread, depth - 1, ply + 1, -alpha - 1, -alpha, true);
+            if (pvNode && (moveCount == 1 || (value > alpha && value < beta)))
+                value =
+                    -negamax(thread, depth - 1, ply + 1, -beta, -alpha, true);
+        } else {
+            value = -negamax(
+                thread, depth - 1 - reduction, ply + 1, -beta, -alpha, true);
+            if (reduction > 0 && value > alpha)
+                value =
+                    -negamax(thread, depth - 1, ply + 1, -beta, -alpha, true);
         }
+        board.undoMove(move, undo);
+
+        if (stopped)
+            return 0;
 
-        if (tempBoard.isCheckmate(!board.isWhite(move.fromX, move.fromY))) {
-            score = std::numeric_limits<int>::max();
+        if (value > bestValue) {
+            bestValue = value;
+            if (value > alpha) {
+                alpha = value;
+                bestMove = move;
+                updatePv(thread, ply, move);
+            }
+        }
+        if (alpha >= beta) {
+            ++thread.stats.cutoffs;
+            if (moveCount == 1)
+                ++thread.stats.firstMoveCutoffs;
+            if (quiet)
+                updateQuietStats(
+                    thread, move, depth, ply, quietsTried, quietCount);
+            break;
         }
+        if (quiet)
+            quietsTried[quietCount++] = move;
+    }
+
+    // Ходов нет вовсе: мат или пат. Если все ходы отсечены как
+    // бесперспективные, остаётся статическая оценка
+    if (moveCount == 0)
+        return inCheck ? -MATE_SCORE + ply : 0;
+    if (bestValue == -INF_SCORE)
+        return staticEval;
+
+    TTBound bound = TT_EXACT;
+    if (bestValue <= alphaOrig)
+        bound = TT_UPPER;
+    else if (bestValue >= beta)
+        bound = TT_LOWER;
+    tt.store(key, depth, scoreToTT(bestValue, ply), bound, bestMove);
+
+    return bestValue;
+}
+
+int ChessEngine::quiescence(SearchThread &thread, int ply, int alpha, int beta)
+{
+    thread.nodes.store(thread.nodes.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+    ++thread.stats.qnodes;
+    if (checkLimits(thread))
+        return 0;
 
-        scoredMoves.emplace_back(score, move);
+    Board &board = thread.board;
+    const bool white = board.isWhiteToMove();
+    const bool inCheck = board.isCheck(white);
+    if (ply >= MAX_PLY)
+        return inCheck ? 0 : evaluate(board);
+
+    // Под шахом перебираем все ответы: оценке позиции верить нельзя.
+    // Иначе сторона может остановиться (stand pat) и рассматривать
+    // только взятия и превращения
+    MoveList moves;
+    int best;
+    if (inCheck) {
+        moves = board.generateAllMoves(white);
+        if (moves.empty())
+            return -MATE_SCORE + ply;
+        best = -INF_SCORE;
+    } else {
+        best = evaluate(board);
+        if (best >= beta)
+            return best;
+        alpha = std::max(alpha, best);
+        moves = board.generateCaptures(white);
     }
 
-    std::sort(scoredMoves.rbegin(),
-              scoredMoves.rend(),
-              [](const auto &a, const auto &b) { return a.first > b.first; });
+    // Проигрывающие по SEE взятия отбрасываем, остальные - от выгодных
+    std::pair<int, Move> scoredMoves[MoveList::MAX_MOVES];
+    int count = 0;
+    {
+        SEARCH_TIMER(TIMER_ORDERING);
+        for (const Move &move : moves) {
+            const int gain = board.see(move);
+            if (!inCheck && gain < 0)
+                continue;
+            scoredMoves[count++] = {gain, move};
+        }
+        std::sort(scoredMoves,
+                  scoredMoves + count,
+                  [](const auto &a, const auto &b) { return a.first > b.first; });
+    }
 
-    std::vector<Move> result;
-    for (const auto &[score, move] : scoredMoves) {
-        result.push_back(move);
+    for (int i = 0; i < count; ++i) {
+        const Move &move = scoredMoves[i].second;
+        UndoInfo undo;
+        board.doMove(move, undo);
+        const int value = -quiescence(thread, ply + 1, -beta, -alpha);
+        board.undoMove(move, undo);
+        if (stopped)
+            return 0;
+
+        best = std::max(best, value);
+        alpha = std::max(alpha, value);
+        if (alpha >= beta)
+            break;
     }
 
-    return result;
-}
\ No newline at end of file
+    return best;
+}
+
+int ChessEngine::evaluate(const Board &board)
+{
+    const int score = evaluateBoard(board);
+    return board.isWhiteToMove() ? score : -score;
+}
+
+int ChessEngine::evaluateBoard(const Board &board)
+{
+    SEARCH_TIMER(TIMER_EVAL);
+
+    // Мат и пат поиск узнаёт из ходов узла, а оценку зовёт только без шаха.
+    // Материал и таблицы фигура-поле Board ведёт инкрементально, здесь
+    // остаётся только смешать оценки миттельшпиля и эндшпиля по стадии
+    const int phase = std::min(board.getPhase(), MAX_PHASE);
+    int score = (board.getMgScore() * phase +
+                 board.getEgScore() * (MAX_PHASE - phase)) /
+                MAX_PHASE;
+
+    if (popCount(board.getPieces(WHITE, PT_BISHOP)) >= 2)
+        score += 30;
+    if (popCount(board.getPieces(BLACK, PT_BISHOP)) >= 2)
+        score -= 30;
+
+    return score;
+}
+
+void SearchThread::clearHeuristics()
+{
+    for (auto &plyKillers : killers) {
+        plyKillers[0] = plyKillers[1] = Move();
+    }
+    for (auto &row : counterMoves) {
+        std::fill(std::begin(row), std::end(row), Move());
+    }
+    // История между ходами партии полезна, но устаревает: делим пополам
+    for (auto &side : history) {
+        for (auto &row : side) {
+            for (int &value : row) {
+                value /= 2;
+            }
+        }
+    }
+}
+
+void ChessEngine::updateQuietStats(SearchThread &thread,
+                                   const Move &move,
+                                   int depth,
+                                   int ply,
+                                   const Move *quietsTried,
+                                   int quietCount)
+{
+    if (thread.killers[ply][0] != move) {
+        thread.killers[ply][1] = thread.killers[ply][0];
+        thread.killers[ply][0] = move;
+    }
+
+    const Move &previous = thread.moveStack[ply - 1];
+    if (previous.isValid()) {
+        thread.counterMoves[previous.from()][previous.to()] = move;
+    }
+
+    // Отсёкший ход поощряем, перебранные до него тихие ходы штрафуем
+    const Color us = thread.board.isWhiteToMove() ? WHITE : BLACK;
+    const int bonus = std::min(depth * depth, 400);
+    addHistory(thread.history[us][move.from()][move.to()], bonus);
+    for (int i = 0; i < quietCount; ++i) {
+        const Move &quiet = quietsTried[i];
+        addHistory(thread.history[us][quiet.from()][quiet.to()], -bonus);
+    }
+}
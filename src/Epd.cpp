@@ -0,0 +1,279 @@
+#include "../include/Epd.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Итог одной позиции; заполняет тот поток, который её решал
+struct EpdResult {
+    std::string move;
+    bool solved = false;
+    uint64_t nodes = 0;
+    std::string error;
+};
+
+// Операции разделены ";", операнды - пробелами, строки бывают в кавычках
+std::vector<std::vector<std::string>> splitOperations(const std::string &text)
+{
+    std::vector<std::vector<std::string>> operations;
+    std::vector<std::string> current;
+    std::string token;
+    bool quoted = false;
+
+    auto flushToken = [&] {
+        if (!token.empty()) {
+            current.push_back(token);
+            token.clear();
+        }
+    };
+
+    for (const char c : text) {
+        if (c == '"') {
+            quoted = !quoted;
+        } else if (quoted) {
+            token += c;
+        } else if (c == ';') {
+            flushToken();
+            if (!current.empty()) {
+                operations.push_back(current);
+                current.clear();
+            }
+        } else if (isspace(static_cast<unsigned char>(c))) {
+            flushToken();
+        } else {
+            token += c;
+        }
+    }
+    flushToken();
+    if (!current.empty()) {
+        operations.push_back(current);
+    }
+    return operations;
+}
+
+bool matchesAny(const Board &board,
+                const Move &move,
+                const std::vector<std::string> &candidates,
+                std::string &error)
+{
+    for (const std::string &text : candidates) {
+        const Move candidate = board.parseSan(text);
+        if (!candidate.isValid()) {
+            error = "нелегальный ход " + text;
+        } else if (candidate == move) {
+            return true;
+        }
+    }
+    return false;
+}
+
+EpdResult solve(ChessEngine &engine,
+                const EpdEntry &entry,
+                const SearchLimits &limits)
+{
+    EpdResult result;
+    try {
+        Board board = Board::fromFEN(entry.fen);
+        engine.clearHash();
+        const SearchResult search = engine.search(board, limits);
+        result.nodes = engine.getStats().nodes;
+        if (!search.bestMove.isValid()) {
+            result.error = "нет легальных ходов";
+            return result;
+        }
+
+        result.move = board.toSan(search.bestMove);
+        result.solved = true;
+        if (!entry.bestMoves.empty()) {
+            result.solved =
+                matchesAny(board, search.bestMove, entry.bestMoves, result.error);
+        }
+        if (!entry.avoidMoves.empty() &&
+            matchesAny(board, search.bestMove, entry.avoidMoves, result.error)) {
+            result.solved = false;
+        }
+    } catch (const std::exception &e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+std::string joinMoves(const std::vector<std::string> &moves)
+{
+    std::string result;
+    for (const std::string &move : moves) {
+        result += (result.empty() ? "" : " ") + move;
+    }
+    return result;
+}
+
+} // namespace
+
+EpdEntry parseEpdLine(const std::string &line)
+{
+    std::istringstream in(line);
+    std::string placement, side, castling, ep;
+    if (!(in >> placement >> side >> castling >> ep)) {
+        throw std::invalid_argument("Некорректная строка EPD: " + line);
+    }
+
+    EpdEntry entry;
+    entry.fen = placement + " " + side + " " + castling + " " + ep;
+
+    std::string rest;
+    std::getline(in, rest);
+    for (const auto &operation : splitOperations(rest)) {
+        const std::string &opcode = operation[0];
+        const std::vector<std::string> operands(operation.begin() + 1,
+                                                operation.end());
+        if (opcode == "bm") {
+            entry.bestMoves = operands;
+        } else if (opcode == "am") {
+            entry.avoidMoves = operands;
+        } else if (opcode == "id" && !operands.empty()) {
+            entry.id = operands[0];
+        }
+    }
+
+    // Проверяем FEN сразу, чтобы ошибка указывала на строку файла
+    Board::fromFEN(entry.fen);
+    return entry;
+}
+
+std::vector<EpdEntry> readEpd(std::istream &in)
+{
+    std::vector<EpdEntry> entries;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos ||
+            line[0] == '#') {
+            continue;
+        }
+        entries.push_back(parseEpdLine(line));
+        if (entries.back().id.empty()) {
+            entries.back().id = "#" + std::to_string(entries.size());
+        }
+    }
+    return entries;
+}
+
+EpdSummary runEpd(const std::vector<EpdEntry> &entries,
+                  const EpdOptions &options,
+                  std::ostream &out)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<EpdResult> results(entries.size());
+
+    // Каждый поток - отдельный однопоточный движок; позиции раздаются
+    // по одной через общий счётчик, как корневые ходы в perft
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        ChessEngine engine(options.hashMegabytes);
+        for (size_t i = next++; i < entries.size(); i = next++) {
+            results[i] = solve(engine, entries[i], options.limits);
+        }
+    };
+
+    const int threadCount = std::max(options.threads, 1);
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threadCount; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+
+    EpdSummary summary;
+    summary.positions = static_cast<int>(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const EpdEntry &entry = entries[i];
+        const EpdResult &result = results[i];
+        out << entry.id << ": " << (result.solved ? "ok  " : "fail") << " "
+            << (result.move.empty() ? "-" : result.move);
+        if (!entry.bestMoves.empty()) {
+            out << " (bm " << joinMoves(entry.bestMoves) << ")";
+        }
+        if (!entry.avoidMoves.empty()) {
+            out << " (am " << joinMoves(entry.avoidMoves) << ")";
+        }
+        if (!result.error.empty()) {
+            out << " [" << result.error << "]";
+        }
+        out << "\n";
+
+        summary.solved += result.solved ? 1 : 0;
+        summary.nodes += result.nodes;
+    }
+
+    summary.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+
+    out << "\nSolved: " << summary.solved << " / " << summary.positions
+        << "\n";
+    out << "Nodes: " << summary.nodes << "\n";
+    out << "Time: " << summary.seconds << " s\n";
+    out << "NPS: "
+        << static_cast<uint64_t>(
+               summary.seconds > 0 ? summary.nodes / summary.seconds : 0)
+        << "\n";
+    return summary;
+}
+
+int epdCommand(int argc, char *argv[])
+{
+    // chessbot epd <file> [--movetime <ms>] [--nodes <N>] [--depth <N>]
+    //                     [--threads <N>] [--hash <MB>]
+    EpdOptions options;
+    std::vector<EpdEntry> entries;
+    try {
+        if (argc < 3) {
+            throw std::invalid_argument("не указан файл");
+        }
+        for (int i = 3; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--movetime" && i + 1 < argc) {
+                options.limits.maxTimeMs = std::stoll(argv[++i]);
+            } else if (arg == "--nodes" && i + 1 < argc) {
+                options.limits.maxNodes = std::stoull(argv[++i]);
+            } else if (arg == "--depth" && i + 1 < argc) {
+                options.limits.maxDepth = std::stoi(argv[++i]);
+            } else if (arg == "--threads" && i + 1 < argc) {
+                options.threads = std::stoi(argv[++i]);
+            } else if (arg == "--hash" && i + 1 < argc) {
+                options.hashMegabytes = std::stoul(argv[++i]);
+            } else {
+                throw std::invalid_argument("неизвестный параметр " + arg);
+            }
+        }
+
+        // Без явного лимита даём по секунде на позицию
+        if (options.limits.maxTimeMs == 0 && options.limits.maxNodes == 0 &&
+            options.limits.maxDepth == SearchLimits().maxDepth) {
+            options.limits.maxTimeMs = 1000;
+        }
+
+        std::ifstream file(argv[2]);
+        if (!file) {
+            throw std::invalid_argument(std::string("не удалось открыть ") +
+                                        argv[2]);
+        }
+        entries = readEpd(file);
+    } catch (const std::exception &e) {
+        std::cerr << "Ошибка: " << e.what() << "\n"
+                  << "Использование: chessbot epd <file> [--movetime <ms>] "
+                     "[--nodes <N>] [--depth <N>] [--threads <N>] "
+                     "[--hash <MB>]\n";
+        return 1;
+    }
+
+    runEpd(entries, options, std::cout);
+    return 0;
+}
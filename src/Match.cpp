@@ -0,0 +1,411 @@
+#include "../include/Match.h"
+#include "../include/Epd.h"
+#include "../include/Psqt.h"
+#include "../include/Zobrist.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const std::string START_FEN =
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Итог партии: result - очки белых (1, 0.5, 0), reason - причина окончания
+struct GameResult {
+    double result = 0.5;
+    std::string reason;
+    uint64_t nodes[2] = {}; // по цветам: 0 - белые, 1 - чёрные
+    double seconds[2] = {};
+};
+
+double expectedScore(double elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double eloFromScore(double score)
+{
+    // При счёте 0% или 100% разница бесконечна; ограничиваем её
+    score = std::min(std::max(score, 0.001), 0.999);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// Дисперсия очков за партию по трёхзначному распределению W/D/L. К каждому
+// исходу добавляется по половине партии, иначе серия одних ничьих даёт
+// нулевую дисперсию и SPRT никогда не останавливается
+double scoreVariance(const MatchSummary &summary)
+{
+    const double w = summary.wins + 0.5;
+    const double d = summary.draws + 0.5;
+    const double l = summary.losses + 0.5;
+    const double n = w + d + l;
+    const double s = (w + 0.5 * d) / n;
+    return (w * (1 - s) * (1 - s) + d * (0.5 - s) * (0.5 - s) + l * s * s) / n;
+}
+
+bool parseSwitch(const std::string &value)
+{
+    if (value == "on" || value == "true" || value == "1")
+        return true;
+    if (value == "off" || value == "false" || value == "0")
+        return false;
+    throw std::invalid_argument("ожидалось on или off: " + value);
+}
+
+// Позиция встречалась трижды. Сравниваем только позиции с той же
+// стороной хода и только после последнего взятия или хода пешкой
+bool isRepetition(const std::vector<uint64_t> &history, int halfmoveClock)
+{
+    const int last = static_cast<int>(history.size()) - 1;
+    const int first = std::max(0, last - halfmoveClock);
+    int count = 1;
+    for (int i = last - 2; i >= first; i -= 2) {
+        if (history[i] == history[last] && ++count >= 3)
+            return true;
+    }
+    return false;
+}
+
+GameResult playGame(ChessEngine *players[2],
+                    const std::string &fen,
+                    const MatchOptions &options)
+{
+    GameResult game;
+    Board board = Board::fromFEN(fen);
+    for (int i = 0; i < 2; ++i) {
+        players[i]->clearHash();
+    }
+
+    std::vector<uint64_t> history{board.getHash()};
+    for (int plies = 0;; ++plies) {
+        const NodeStatus status = board.nodeStatus(board.isWhiteToMove());
+        if (status.moves.empty()) {
+            if (status.inCheck) {
+                game.result = board.isWhiteToMove() ? 0.0 : 1.0;
+                game.reason = "checkmate";
+            } else {
+                game.reason = "stalemate";
+            }
+            return game;
+        }
+        if (isRepetition(history, board.getHalfmoveClock())) {
+            game.reason = "repetition";
+            return game;
+        }
+        if (board.getHalfmoveClock() >= 100) {
+            game.reason = "fifty moves";
+            return game;
+        }
+        if (plies >= options.maxMoves * 2) {
+            game.reason = "move limit";
+            return game;
+        }
+
+        const int side = board.isWhiteToMove() ? 0 : 1;
+        ChessEngine &engine = *players[side];
+        const auto start = std::chrono::steady_clock::now();
+        const SearchResult search = engine.search(board, options.limits);
+        game.seconds[side] += std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+        game.nodes[side] += engine.getStats().nodes;
+
+        // Поиск без завершённой итерации всё равно даёт первый корневой ход
+        const Move move =
+            search.bestMove.isValid() ? search.bestMove : status.moves[0];
+        UndoInfo undo;
+        board.doMove(move, undo);
+        history.push_back(board.getHash());
+    }
+}
+
+std::string resultText(double result)
+{
+    return result == 1.0 ? "1-0" : result == 0.0 ? "0-1" : "1/2-1/2";
+}
+
+void printSummary(const MatchSummary &summary,
+                  const MatchOptions &options,
+                  std::ostream &out)
+{
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(1);
+
+    out << "Score of " << options.engines[0].name << " vs "
+        << options.engines[1].name << ": " << summary.wins << " - "
+        << summary.losses << " - " << summary.draws << " ["
+        << std::setprecision(3) << summary.score() << std::setprecision(1)
+        << "] " << summary.games() << "\n";
+    out << "Elo difference: " << summary.elo() << " +/- "
+        << summary.eloError() << "\n";
+    for (int i = 0; i < 2; ++i) {
+        const double seconds = summary.seconds[i];
+        out << options.engines[i].name << " nodes: " << summary.nodes[i]
+            << ", NPS: "
+            << static_cast<uint64_t>(seconds > 0 ? summary.nodes[i] / seconds
+                                                 : 0)
+            << "\n";
+    }
+    if (options.sprt) {
+        out << std::setprecision(2) << "LLR: "
+            << summary.llr(options.elo0, options.elo1) << " ("
+            << std::log(options.beta / (1 - options.alpha)) << ", "
+            << std::log((1 - options.beta) / options.alpha) << ") [" << options.elo0
+            << ", " << options.elo1 << "]\n";
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace
+
+double MatchSummary::score() const
+{
+    const int n = games();
+    return n > 0 ? (wins + 0.5 * draws) / n : 0.5;
+}
+
+double MatchSummary::elo() const
+{
+    return eloFromScore(score());
+}
+
+double MatchSummary::eloError() const
+{
+    const int n = games();
+    if (n == 0)
+        return 0;
+    const double s = score();
+    const double margin = 1.96 * std::sqrt(scoreVariance(*this) / n);
+    return (eloFromScore(s + margin) - eloFromScore(s - margin)) / 2;
+}
+
+double MatchSummary::llr(double elo0, double elo1) const
+{
+    // Нормальное приближение обобщённого SPRT по среднему и дисперсии очков
+    const int n = games();
+    if (n == 0)
+        return 0;
+    const double s = score();
+    const double variance = scoreVariance(*this);
+    const double s0 = expectedScore(elo0);
+    const double s1 = expectedScore(elo1);
+    return n * (s1 - s0) * (2 * s - s0 - s1) / (2 * variance);
+}
+
+EngineConfig parseEngineConfig(const std::string &spec)
+{
+    // name=dev,hash=32,threads=2,pvs=on,null=off,lmr=on,futility=on
+    EngineConfig config;
+    std::istringstream in(spec);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument("ожидалось ключ=значение: " + item);
+        }
+        const std::string key = item.substr(0, eq);
+        const std::string value = item.substr(eq + 1);
+        if (key == "name") {
+            config.name = value;
+        } else if (key == "hash") {
+            config.hashMegabytes = std::stoul(value);
+        } else if (key == "threads") {
+            config.threads = std::stoi(value);
+        } else if (key == "pvs") {
+            config.options.pvs = parseSwitch(value);
+        } else if (key == "null") {
+            config.options.nullMove = parseSwitch(value);
+        } else if (key == "lmr") {
+            config.options.lmr = parseSwitch(value);
+        } else if (key == "futility") {
+            config.options.futility = parseSwitch(value);
+        } else {
+            throw std::invalid_argument("неизвестная настройка " + key);
+        }
+    }
+    return config;
+}
+
+MatchSummary runMatch(const MatchOptions &options, std::ostream &out)
+{
+    const std::vector<std::string> openings =
+        options.openings.empty() ? std::vector<std::string>{START_FEN}
+                                 : options.openings;
+    const double lower = std::log(options.beta / (1 - options.alpha));
+    const double upper = std::log((1 - options.beta) / options.alpha);
+
+    MatchSummary summary;
+    std::mutex summaryMutex;
+    std::atomic<bool> stopped{false};
+
+    // Партии раздаются по одной через общий счётчик. У потока своя пара
+    // движков, между партиями у них очищается только таблица
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        ChessEngine engines[2] = {
+            ChessEngine(options.engines[0].hashMegabytes),
+            ChessEngine(options.engines[1].hashMegabytes)};
+        for (int i = 0; i < 2; ++i) {
+            engines[i].setOptions(options.engines[i].options);
+            engines[i].setThreads(options.engines[i].threads);
+        }
+
+        for (int game = next++; game < options.games && !stopped;
+             game = next++) {
+            // Чётные партии первый участник играет белыми, нечётные - той
+            // же дебютной позицией чёрными
+            const int white = game % 2;
+            ChessEngine *players[2] = {&engines[white], &engines[1 - white]};
+            const std::string &fen = openings[(game / 2) % openings.size()];
+
+            GameResult result;
+            try {
+                result = playGame(players, fen, options);
+            } catch (const std::exception &e) {
+                std::lock_guard<std::mutex> lock(summaryMutex);
+                out << "Game " << game + 1 << ": ошибка " << e.what() << "\n";
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(summaryMutex);
+            const double score = white == 0 ? result.result : 1 - result.result;
+            summary.wins += score == 1.0 ? 1 : 0;
+            summary.draws += score == 0.5 ? 1 : 0;
+            summary.losses += score == 0.0 ? 1 : 0;
+            for (int side = 0; side < 2; ++side) {
+                const int engine = side == 0 ? white : 1 - white;
+                summary.nodes[engine] += result.nodes[side];
+                summary.seconds[engine] += result.seconds[side];
+            }
+
+            out << "Game " << game + 1 << " ("
+                << options.engines[white].name << " vs "
+                << options.engines[1 - white].name
+                << "): " << resultText(result.result) << " {"
+                << result.reason << "}, score " << summary.wins << " - "
+                << summary.losses << " - " << summary.draws << "\n";
+
+            if (options.sprt) {
+                const double llr = summary.llr(options.elo0, options.elo1);
+                if (!stopped && (llr <= lower || llr >= upper)) {
+                    stopped = true;
+                    out << "SPRT: " << (llr >= upper ? "H1" : "H0")
+                        << " accepted\n";
+                }
+            }
+        }
+    };
+
+    // Общие таблицы строим до запуска потоков, а не в первых партиях
+    initBitboards();
+    initZobrist();
+    initPsqt();
+
+    const int threadCount = std::max(options.concurrency, 1);
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threadCount; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+
+    out << "\n";
+    printSummary(summary, options, out);
+    return summary;
+}
+
+int matchCommand(int argc, char *argv[])
+{
+    // chessbot match [--engine1 <spec>] [--engine2 <spec>] [--games <N>]
+    //                [--concurrency <N>] [--movetime <ms>] [--nodes <N>]
+    //                [--depth <N>] [--openings <file>] [--max-moves <N>]
+    //                [--elo0 <x>] [--elo1 <x>] [--alpha <x>] [--beta <x>]
+    //                [--no-sprt]
+    MatchOptions options;
+    options.engines[0].name = "engine1";
+    options.engines[1].name = "engine2";
+    try {
+        for (int i = 2; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if ((arg == "--engine1" || arg == "--engine2") && hasValue) {
+                const int index = arg == "--engine1" ? 0 : 1;
+                const std::string name = options.engines[index].name;
+                options.engines[index] = parseEngineConfig(argv[++i]);
+                if (options.engines[index].name.empty()) {
+                    options.engines[index].name = name;
+                }
+            } else if (arg == "--games" && hasValue) {
+                options.games = std::stoi(argv[++i]);
+            } else if (arg == "--concurrency" && hasValue) {
+                options.concurrency = std::stoi(argv[++i]);
+            } else if (arg == "--movetime" && hasValue) {
+                options.limits.maxTimeMs = std::stoll(argv[++i]);
+            } else if (arg == "--nodes" && hasValue) {
+                options.limits.maxNodes = std::stoull(argv[++i]);
+            } else if (arg == "--depth" && hasValue) {
+                options.limits.maxDepth = std::stoi(argv[++i]);
+            } else if (arg == "--max-moves" && hasValue) {
+                options.maxMoves = std::stoi(argv[++i]);
+            } else if (arg == "--elo0" && hasValue) {
+                options.elo0 = std::stod(argv[++i]);
+            } else if (arg == "--elo1" && hasValue) {
+                options.elo1 = std::stod(argv[++i]);
+            } else if (arg == "--alpha" && hasValue) {
+                options.alpha = std::stod(argv[++i]);
+            } else if (arg == "--beta" && hasValue) {
+                options.beta = std::stod(argv[++i]);
+            } else if (arg == "--no-sprt") {
+                options.sprt = false;
+            } else if (arg == "--openings" && hasValue) {
+                std::ifstream file(argv[++i]);
+                if (!file) {
+                    throw std::invalid_argument(std::string("не удалось открыть ") +
+                                                argv[i]);
+                }
+                for (const EpdEntry &entry : readEpd(file)) {
+                    options.openings.push_back(entry.fen);
+                }
+            } else {
+                throw std::invalid_argument("неизвестный параметр " + arg);
+            }
+        }
+
+        if (options.alpha <= 0 || options.alpha >= 1 || options.beta <= 0 ||
+            options.beta >= 1) {
+            throw std::invalid_argument("alpha и beta должны быть между 0 и 1");
+        }
+
+        // Без явного лимита даём по 100 мс на ход
+        if (options.limits.maxTimeMs == 0 && options.limits.maxNodes == 0 &&
+            options.limits.maxDepth == SearchLimits().maxDepth) {
+            options.limits.maxTimeMs = 100;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Ошибка: " << e.what() << "\n"
+                  << "Использование: chessbot match [--engine1 <spec>] "
+                     "[--engine2 <spec>] [--games <N>] [--concurrency <N>] "
+                     "[--movetime <ms>] [--nodes <N>] [--depth <N>] "
+                     "[--openings <file>] [--max-moves <N>] [--elo0 <x>] "
+                     "[--elo1 <x>] [--alpha <x>] [--beta <x>] [--no-sprt]\n"
+                  << "spec: name=<имя>,hash=<MB>,threads=<N>,pvs=on|off,"
+                     "null=on|off,lmr=on|off,futility=on|off\n";
+        return 1;
+    }
+
+    runMatch(options, std::cout);
+    return 0;
+}
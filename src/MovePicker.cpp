@@ -0,0 +1,142 @@
+#include "../include/MovePicker.h"
+#include "../include/SearchStats.h"
+
+namespace {
+
+constexpr int COUNTER_BONUS = 1 << 20;
+
+// [жертва][нападающий]: сначала самая ценная жертва, затем дешёвый нападающий
+constexpr int MvvLva[6][6] = {
+    {15, 14, 13, 12, 11, 10},
+    {25, 24, 23, 22, 21, 20},
+    {35, 34, 33, 32, 31, 30},
+    {45, 44, 43, 42, 41, 40},
+    {55, 54, 53, 52, 51, 50},
+    {0, 0, 0, 0, 0, 0},
+};
+
+} // namespace
+
+MovePicker::MovePicker(const Board &board,
+                       const Move &ttMove,
+                       const Move *killers,
+                       const Move &counterMove,
+                       const int (*history)[64][64])
+    : board(board), ttMove(ttMove), counterMove(counterMove), history(history)
+{
+    this->killers[0] = killers ? killers[0] : Move();
+    this->killers[1] = killers ? killers[1] : Move();
+}
+
+void MovePicker::scoreCaptures()
+{
+    SEARCH_TIMER(TIMER_ORDERING);
+    for (int i = 0; i < moves.size(); ++i) {
+        const Move &move = moves[i];
+        const char target = board.board[move.toX()][move.toY()];
+        const PieceType victim = target != EMPTY ? pieceTypeOf(target) : PT_PAWN;
+        const PieceType attacker =
+            pieceTypeOf(board.board[move.fromX()][move.fromY()]);
+        scores[i] = MvvLva[victim][attacker];
+        if (move.isPromotion())
+            scores[i] += 100 * move.promotionType();
+    }
+}
+
+void MovePicker::scoreQuiets()
+{
+    SEARCH_TIMER(TIMER_ORDERING);
+    const Color us = board.isWhiteToMove() ? WHITE : BLACK;
+    for (int i = 0; i < moves.size(); ++i) {
+        const Move &move = moves[i];
+        scores[i] = history[us][move.from()][move.to()];
+        if (move == counterMove)
+            scores[i] += COUNTER_BONUS;
+    }
+}
+
+Move MovePicker::pickBest()
+{
+    SEARCH_TIMER(TIMER_ORDERING);
+    // Один шаг сортировки выбором: при раннем отсечении хвост не сортируется
+    int best = current;
+    for (int i = current + 1; i < moves.size(); ++i) {
+        if (scores[i] > scores[best])
+            best = i;
+    }
+    std::swap(moves[current], moves[best]);
+    std::swap(scores[current], scores[best]);
+    return moves[current++];
+}
+
+Move MovePicker::next()
+{
+    switch (stage) {
+    case STAGE_TT:
+        stage = STAGE_GEN_CAPTURES;
+        if (ttMove.isValid() && board.isLegal(ttMove))
+            return ttMove;
+        [[fallthrough]];
+
+    case STAGE_GEN_CAPTURES:
+        moves.clear();
+        board.generateMoves(board.isWhiteToMove(), GEN_CAPTURES, moves);
+        scoreCaptures();
+        current = 0;
+        stage = STAGE_GOOD_CAPTURES;
+        [[fallthrough]];
+
+    case STAGE_GOOD_CAPTURES:
+        while (current < moves.size()) {
+            const Move move = pickBest();
+            if (move == ttMove)
+                continue;
+            // Проигрывающие по SEE взятия откладываем в самый конец
+            if (board.see(move) < 0) {
+                badCaptures.add(move);
+                continue;
+            }
+            return move;
+        }
+        stage = STAGE_KILLERS;
+        [[fallthrough]];
+
+    case STAGE_KILLERS:
+        // Киллер легален, только если здесь он тоже тихий ход
+        while (killerIndex < 2) {
+            const Move killer = killers[killerIndex++];
+            if (killer.isValid() && killer != ttMove && !killer.isCapture() &&
+                !killer.isPromotion() && board.isLegal(killer))
+                return killer;
+        }
+        stage = STAGE_GEN_QUIETS;
+        [[fallthrough]];
+
+    case STAGE_GEN_QUIETS:
+        moves.clear();
+        board.generateMoves(board.isWhiteToMove(), GEN_QUIETS, moves);
+        scoreQuiets();
+        current = 0;
+        stage = STAGE_QUIETS;
+        [[fallthrough]];
+
+    case STAGE_QUIETS:
+        while (current < moves.size()) {
+            const Move move = pickBest();
+            if (move != ttMove && move != killers[0] && move != killers[1])
+                return move;
+        }
+        stage = STAGE_BAD_CAPTURES;
+        [[fallthrough]];
+
+    case STAGE_BAD_CAPTURES:
+        if (badIndex < badCaptures.size())
+            return badCaptures[badIndex++];
+        stage = STAGE_DONE;
+        [[fallthrough]];
+
+    case STAGE_DONE:
+        break;
+    }
+    return Move();
+}
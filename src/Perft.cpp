@@ -0,0 +1,165 @@
+#include "../include/Perft.h"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+PerftHash::PerftHash(size_t megabytes)
+{
+    const size_t bytes = megabytes * 1024 * 1024;
+    size_t count = 1;
+    while (count * 2 * sizeof(Entry) <= bytes) {
+        count *= 2;
+    }
+    entries = std::make_unique<Entry[]>(count);
+    for (size_t i = 0; i < count; ++i) {
+        entries[i].check.store(0, std::memory_order_relaxed);
+        entries[i].data.store(0, std::memory_order_relaxed);
+    }
+    mask = count - 1;
+}
+
+bool PerftHash::probe(uint64_t key, int depth, uint64_t &nodes) const
+{
+    const Entry &entry = entries[key & mask];
+    const uint64_t data = entry.data.load(std::memory_order_relaxed);
+    const uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || static_cast<int>(data & 0xFF) != depth) {
+        return false;
+    }
+    nodes = data >> 8;
+    return true;
+}
+
+void PerftHash::store(uint64_t key, int depth, uint64_t nodes)
+{
+    Entry &entry = entries[key & mask];
+    const uint64_t data = (nodes << 8) | static_cast<uint64_t>(depth);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+uint64_t perft(Board &board, int depth, PerftHash *hash)
+{
+    const MoveList moves = board.generateAllMoves(board.isWhiteToMove());
+    if (depth <= 1) {
+        return depth == 1 ? moves.size() : 1;
+    }
+
+    uint64_t nodes = 0;
+    if (hash && hash->probe(board.getHash(), depth, nodes)) {
+        return nodes;
+    }
+
+    for (const Move &move : moves) {
+        UndoInfo undo;
+        board.doMove(move, undo);
+        nodes += perft(board, depth - 1, hash);
+        board.undoMove(move, undo);
+    }
+
+    if (hash) {
+        hash->store(board.getHash(), depth, nodes);
+    }
+    return nodes;
+}
+
+uint64_t runPerft(const Board &board,
+                  const PerftOptions &options,
+                  std::ostream &out)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    Board root = board;
+    const MoveList moves = root.generateAllMoves(root.isWhiteToMove());
+    std::vector<uint64_t> counts(moves.size(), 0);
+
+    std::unique_ptr<PerftHash> hash;
+    if (options.hashMegabytes > 0) {
+        hash = std::make_unique<PerftHash>(options.hashMegabytes);
+    }
+
+    // Корневые ходы раздаются потокам по одному через общий счётчик
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        Board local = board;
+        for (int i = next++; i < moves.size(); i = next++) {
+            UndoInfo undo;
+            local.doMove(moves[i], undo);
+            counts[i] = perft(local, options.depth - 1, hash.get());
+            local.undoMove(moves[i], undo);
+        }
+    };
+
+    uint64_t total = 0;
+    if (options.depth <= 0) {
+        total = 1;
+    } else {
+        const int threadCount = options.threads > 1 ? options.threads : 1;
+        std::vector<std::thread> pool;
+        for (int i = 1; i < threadCount; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : pool) {
+            thread.join();
+        }
+
+        for (int i = 0; i < moves.size(); ++i) {
+            if (options.divide) {
+                out << moves[i].toUci() << ": " << counts[i] << "\n";
+            }
+            total += counts[i];
+        }
+    }
+
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+
+    if (options.divide) {
+        out << "\n";
+    }
+    out << "Nodes: " << total << "\n";
+    out << "Time: " << seconds << " s\n";
+    out << "NPS: "
+        << static_cast<uint64_t>(seconds > 0 ? total / seconds : 0) << "\n";
+    return total;
+}
+
+int perftCommand(int argc, char *argv[])
+{
+    // chessbot perft <depth> [--fen "<FEN>"] [--divide] [--hash <MB>]
+    //                        [--threads <N>]
+    PerftOptions options;
+    Board board;
+    try {
+        if (argc < 3) {
+            throw std::invalid_argument("не указана глубина");
+        }
+        options.depth = std::stoi(argv[2]);
+        for (int i = 3; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--divide") {
+                options.divide = true;
+            } else if (arg == "--fen" && i + 1 < argc) {
+                board = Board::fromFEN(argv[++i]);
+            } else if (arg == "--hash" && i + 1 < argc) {
+                options.hashMegabytes = std::stoul(argv[++i]);
+            } else if (arg == "--threads" && i + 1 < argc) {
+                options.threads = std::stoi(argv[++i]);
+            } else {
+                throw std::invalid_argument("неизвестный параметр " + arg);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Ошибка: " << e.what() << "\n"
+                  << "Использование: chessbot perft <depth> [--fen \"<FEN>\"] "
+                     "[--divide] [--hash <MB>] [--threads <N>]\n";
+        return 1;
+    }
+
+    runPerft(board, options, std::cout);
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "../include/Psqt.h"
+#include <mutex>
+
+int PsqtMg[2][6][64];
+int PsqtEg[2][6][64];
+
+namespace {
+
+constexpr int MaterialMg[6] = {100, 320, 330, 500, 900, 0};
+constexpr int MaterialEg[6] = {120, 300, 320, 520, 920, 0};
+
+// Таблицы для белых в порядке клеток доски: первая строка - 8-я горизонталь
+constexpr int PawnMg[64] = {
+    0,  0,  0,   0,   0,   0,   0,  0,
+    50, 50, 50,  50,  50,  50,  50, 50,
+    10, 10, 20,  30,  30,  20,  10, 10,
+    5,  5,  10,  25,  25,  10,  5,  5,
+    0,  0,  0,   20,  20,  0,   0,  0,
+    5,  -5, -10, 0,   0,   -10, -5, 5,
+    5,  10, 10,  -20, -20, 10,  10, 5,
+    0,  0,  0,   0,   0,   0,   0,  0
+};
+
+constexpr int PawnEg[64] = {
+    0,  0,  0,  0,  0,  0,  0,  0,
+    80, 80, 80, 80, 80, 80, 80, 80,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    30, 30, 30, 30, 30, 30, 30, 30,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    5,  5,  5,  5,  5,  5,  5,  5,
+    0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0
+};
+
+constexpr int Knight[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20, 0,   0,   0,   0,   -20, -40,
+    -30, 0,   10,  15,  15,  10,  0,   -30,
+    -30, 5,   15,  20,  20,  15,  5,   -30,
+    -30, 0,   15,  20,  20,  15,  0,   -30,
+    -30, 5,   10,  15,  15,  10,  5,   -30,
+    -40, -20, 0,   5,   5,   0,   -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+constexpr int Bishop[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10, 0,   0,   0,   0,   0,   0,   -10,
+    -10, 0,   5,   10,  10,  5,   0,   -10,
+    -10, 5,   5,   10,  10,  5,   5,   -10,
+    -10, 0,   10,  10,  10,  10,  0,   -10,
+    -10, 10,  10,  10,  10,  10,  10,  -10,
+    -10, 5,   0,   0,   0,   0,   5,   -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+constexpr int RookMg[64] = {
+    0,  0,  0,  0,  0,  0,  0,  0,
+    5,  10, 10, 10, 10, 10, 10, 5,
+    -5, 0,  0,  0,  0,  0,  0,  -5,
+    -5, 0,  0,  0,  0,  0,  0,  -5,
+    -5, 0,  0,  0,  0,  0,  0,  -5,
+    -5, 0,  0,  0,  0,  0,  0,  -5,
+    -5, 0,  0,  0,  0,  0,  0,  -5,
+    0,  0,  0,  5,  5,  0,  0,  0
+};
+
+constexpr int Queen[64] = {
+    -20, -10, -10, -5, -5, -10, -10, -20,
+    -10, 0,   0,   0,  0,  0,   0,   -10,
+    -10, 0,   5,   5,  5,  5,   0,   -10,
+    -5,  0,   5,   5,  5,  5,   0,   -5,
+    0,   0,   5,   5,  5,  5,   0,   -5,
+    -10, 5,   5,   5,  5,  5,   0,   -10,
+    -10, 0,   5,   0,  0,  0,   0,   -10,
+    -20, -10, -10, -5, -5, -10, -10, -20
+};
+
+constexpr int KingMg[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+    20,  20,  0,   0,   0,   0,   20,  20,
+    20,  30,  10,  0,   0,   10,  30,  20
+};
+
+constexpr int KingEg[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10, 0,   0,   -10, -20, -30,
+    -30, -10, 20,  30,  30,  20,  -10, -30,
+    -30, -10, 30,  40,  40,  30,  -10, -30,
+    -30, -10, 30,  40,  40,  30,  -10, -30,
+    -30, -10, 20,  30,  30,  20,  -10, -30,
+    -30, -30, 0,   0,   0,   0,   -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+};
+
+constexpr int RookEg[64] = {};
+
+constexpr const int *TablesMg[6] = {PawnMg, Knight, Bishop, RookMg, Queen, KingMg};
+constexpr const int *TablesEg[6] = {PawnEg, Knight, Bishop, RookEg, Queen, KingEg};
+
+void buildPsqt()
+{
+    for (int type = PT_PAWN; type <= PT_KING; ++type) {
+        for (int sq = 0; sq < 64; ++sq) {
+            // Для чёрных доска отражается по вертикали: sq ^ 56
+            PsqtMg[WHITE][type][sq] = MaterialMg[type] + TablesMg[type][sq];
+            PsqtEg[WHITE][type][sq] = MaterialEg[type] + TablesEg[type][sq];
+            PsqtMg[BLACK][type][sq] =
+                -(MaterialMg[type] + TablesMg[type][sq ^ 56]);
+            PsqtEg[BLACK][type][sq] =
+                -(MaterialEg[type] + TablesEg[type][sq ^ 56]);
+        }
+    }
+}
+
+} // namespace
+
+void initPsqt()
+{
+    // Первыми таблицы могут запросить сразу несколько потоков
+    static std::once_flag once;
+    std::call_once(once, buildPsqt);
+}
@@ -0,0 +1,170 @@
+#include "../include/SearchStats.h"
+#include <algorithm>
+#include <iomanip>
+
+#ifdef SEARCH_TIMERS
+thread_local uint64_t SearchTimerNs[TIMER_COUNT] = {};
+#endif
+
+namespace {
+
+const char *TimerNames[TIMER_COUNT] = {"movegen", "eval", "ordering"};
+
+double ratio(uint64_t part, uint64_t total)
+{
+    return total > 0 ? static_cast<double>(part) / total : 0.0;
+}
+
+} // namespace
+
+void resetSearchTimers()
+{
+#ifdef SEARCH_TIMERS
+    std::fill(std::begin(SearchTimerNs), std::end(SearchTimerNs), 0);
+#endif
+}
+
+void collectSearchTimers(SearchStats &stats)
+{
+#ifdef SEARCH_TIMERS
+    for (int i = 0; i < TIMER_COUNT; ++i) {
+        stats.timerNs[i] += SearchTimerNs[i];
+    }
+#else
+    (void)stats;
+#endif
+}
+
+void SearchStats::merge(const SearchStats &other)
+{
+    nodes += other.nodes;
+    qnodes += other.qnodes;
+    ttProbes += other.ttProbes;
+    ttHits += other.ttHits;
+    cutoffs += other.cutoffs;
+    firstMoveCutoffs += other.firstMoveCutoffs;
+    tbHits += other.tbHits;
+    timeMs = std::max(timeMs, other.timeMs);
+    threads += other.threads;
+    for (int i = 0; i < TIMER_COUNT; ++i) {
+        timerNs[i] += other.timerNs[i];
+    }
+    // Итерации ведёт только главный поток
+    if (depths.empty())
+        depths = other.depths;
+}
+
+uint64_t SearchStats::nps() const
+{
+    return timeMs > 0 ? nodes * 1000 / timeMs : nodes;
+}
+
+double SearchStats::branchingFactor() const
+{
+    // Отношение узлов двух последних полных итераций
+    const size_t n = depths.size();
+    if (n < 3)
+        return 0.0;
+    const uint64_t last = depths[n - 1].nodes - depths[n - 2].nodes;
+    const uint64_t previous = depths[n - 2].nodes - depths[n - 3].nodes;
+    return ratio(last, previous);
+}
+
+double SearchStats::ttHitRate() const
+{
+    return ratio(ttHits, ttProbes);
+}
+
+double SearchStats::firstMoveCutoffRate() const
+{
+    return ratio(firstMoveCutoffs, cutoffs);
+}
+
+bool SearchStats::hasTimers() const
+{
+    return std::any_of(std::begin(timerNs), std::end(timerNs), [](uint64_t ns) {
+        return ns > 0;
+    });
+}
+
+void SearchStats::printText(std::ostream &out) const
+{
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(1);
+
+    out << "Узлов: " << nodes << " (форсированных " << qnodes << ")\n";
+    out << "Время: " << timeMs << " мс, узлов в секунду: " << nps() << "\n";
+    out << "Потоков: " << threads << "\n";
+    out << "Коэффициент ветвления: " << std::setprecision(2)
+        << branchingFactor() << std::setprecision(1) << "\n";
+    out << "Попаданий в таблицу: " << ttHitRate() * 100 << "% из "
+        << ttProbes << "\n";
+    out << "Отсечений на первом ходе: " << firstMoveCutoffRate() * 100
+        << "% из " << cutoffs << "\n";
+    if (tbHits > 0)
+        out << "Попаданий в таблицы эндшпиля: " << tbHits << "\n";
+
+    if (hasTimers()) {
+        for (int i = 0; i < TIMER_COUNT; ++i) {
+            out << "Таймер " << TimerNames[i] << ": " << timerNs[i] / 1000000
+                << " мс\n";
+        }
+    }
+
+    out << "Глубина  Оценка        Узлы   Время, мс  Ветвление\n";
+    uint64_t previousNodes = 0;
+    uint64_t previousIteration = 0;
+    for (const DepthStats &d : depths) {
+        const uint64_t iteration = d.nodes - previousNodes;
+        out << std::setw(7) << d.depth << std::setw(8) << d.score
+            << std::setw(12) << d.nodes << std::setw(12) << d.timeMs;
+        if (previousIteration > 0)
+            out << std::setw(11) << std::setprecision(2)
+                << ratio(iteration, previousIteration) << std::setprecision(1);
+        out << "\n";
+        previousNodes = d.nodes;
+        previousIteration = iteration;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void SearchStats::printJson(std::ostream &out) const
+{
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(4);
+
+    out << "{\"nodes\":" << nodes << ",\"qnodes\":" << qnodes
+        << ",\"time_ms\":" << timeMs << ",\"nps\":" << nps()
+        << ",\"threads\":" << threads
+        << ",\"branching_factor\":" << branchingFactor()
+        << ",\"tt_probes\":" << ttProbes << ",\"tt_hits\":" << ttHits
+        << ",\"tt_hit_rate\":" << ttHitRate() << ",\"cutoffs\":" << cutoffs
+        << ",\"first_move_cutoffs\":" << firstMoveCutoffs
+        << ",\"first_move_cutoff_rate\":" << firstMoveCutoffRate()
+        << ",\"tb_hits\":" << tbHits;
+
+    if (hasTimers()) {
+        out << ",\"timers_ns\":{";
+        for (int i = 0; i < TIMER_COUNT; ++i) {
+            out << (i > 0 ? "," : "") << "\"" << TimerNames[i]
+                << "\":" << timerNs[i];
+        }
+        out << "}";
+    }
+
+    out << ",\"depths\":[";
+    for (size_t i = 0; i < depths.size(); ++i) {
+        const DepthStats &d = depths[i];
+        out << (i > 0 ? "," : "") << "{\"depth\":" << d.depth
+            << ",\"score\":" << d.score << ",\"nodes\":" << d.nodes
+            << ",\"time_ms\":" << d.timeMs << "}";
+    }
+    out << "]}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
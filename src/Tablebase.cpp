@@ -0,0 +1,455 @@
+#include "../include/Tablebase.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIC[8] = {'C', 'B', 'T', 'B', '1', 0, 0, 0};
+constexpr size_t HEADER_SIZE = 64;
+
+// Заголовок файла таблицы; за ним идут упакованные 64-битные слова
+struct TbHeader {
+    char magic[8];
+    char name[16];
+    uint64_t entries;
+    uint32_t bits;
+    char reserved[HEADER_SIZE - 8 - 16 - 8 - 4];
+};
+static_assert(sizeof(TbHeader) == HEADER_SIZE, "заголовок таблицы - 64 байта");
+
+const char PieceLetters[] = "PNBRQK";
+
+// Без пешек белого короля можно загнать отражениями в треугольник a1-d1-d4
+// (10 полей), с пешками - только отражением по вертикали в левую половину
+struct KingSquares {
+    int triangle[64];
+    int half[64];
+    int triangleCount = 0;
+
+    KingSquares()
+    {
+        for (int sq = 0; sq < 64; ++sq) {
+            const int x = squareX(sq);
+            const int y = squareY(sq);
+            triangle[sq] = x >= 4 && y <= 3 && y >= 7 - x ? triangleCount++ : -1;
+            half[sq] = y <= 3 ? x * 4 + y : -1;
+        }
+    }
+};
+
+const KingSquares Kings;
+
+int flipDiagonal(int sq)
+{
+    return makeSquare(7 - squareY(sq), 7 - squareX(sq));
+}
+
+int transformSquare(int sq, int transform)
+{
+    if (transform & 1)
+        sq ^= 7;
+    if (transform & 2)
+        sq ^= 56;
+    if (transform & 4)
+        sq = flipDiagonal(sq);
+    return sq;
+}
+
+// Отражения, переводящие белого короля в его область индекса. Если король
+// лёг на диагональ a1-h8, по ней решает первая фигура вне диагонали: иначе у
+// позиции было бы два индекса, и обратные ходы попадали бы не в тот
+int canonicalTransform(const TbPosition &position, bool pawns)
+{
+    int transform = 0;
+    int sq = position.square[0];
+    if (squareY(sq) > 3) {
+        transform |= 1;
+        sq ^= 7;
+    }
+    if (pawns)
+        return transform;
+    if (squareX(sq) < 4) {
+        transform |= 2;
+        sq ^= 56;
+    }
+    if (squareY(sq) < 7 - squareX(sq))
+        return transform | 4;
+
+    for (int i = 0; i < position.count && squareY(sq) == 7 - squareX(sq); ++i) {
+        sq = transformSquare(position.square[i], transform);
+    }
+    if (squareY(sq) < 7 - squareX(sq))
+        transform |= 4;
+    return transform;
+}
+
+size_t power64(int n)
+{
+    return static_cast<size_t>(1) << (6 * n);
+}
+
+// Фигуры после королей: сначала белые, затем чёрные, от ферзя к пешке
+void sortPieces(TbPosition &position)
+{
+    for (int i = 3; i < position.count; ++i) {
+        for (int j = i; j > 2; --j) {
+            const bool before =
+                position.color[j] < position.color[j - 1] ||
+                (position.color[j] == position.color[j - 1] &&
+                 position.type[j] > position.type[j - 1]);
+            if (!before)
+                break;
+            std::swap(position.square[j], position.square[j - 1]);
+            std::swap(position.type[j], position.type[j - 1]);
+            std::swap(position.color[j], position.color[j - 1]);
+        }
+    }
+}
+
+TbMaterial materialOf(const TbPosition &position)
+{
+    TbMaterial material;
+    for (int i = 2; i < position.count; ++i) {
+        (position.color[i] == WHITE ? material.white : material.black)
+            .push_back(position.type[i]);
+    }
+    return material;
+}
+
+// Смена цветов: отражение по горизонтали доски, короли и фигуры сторон
+// меняются местами, очередь хода тоже
+TbPosition flipColors(const TbPosition &position)
+{
+    TbPosition flipped = position;
+    for (int i = 0; i < position.count; ++i) {
+        flipped.square[i] = position.square[i] ^ 56;
+        flipped.color[i] = position.color[i] == WHITE ? BLACK : WHITE;
+    }
+    std::swap(flipped.square[0], flipped.square[1]);
+    std::swap(flipped.color[0], flipped.color[1]);
+    flipped.whiteToMove = !position.whiteToMove;
+    sortPieces(flipped);
+    return flipped;
+}
+
+} // namespace
+
+TbMaterial TbMaterial::parse(const std::string &name)
+{
+    // "KQvKR": обе стороны начинаются с короля, разделитель - v
+    const size_t separator = name.find('v');
+    if (separator == std::string::npos || name.size() < 4 || name[0] != 'K' ||
+        separator + 1 >= name.size() || name[separator + 1] != 'K') {
+        throw std::invalid_argument("некорректная сигнатура " + name);
+    }
+
+    TbMaterial material;
+    auto readSide = [&](const std::string &side, std::vector<PieceType> &out) {
+        for (const char c : side) {
+            const char *letter = strchr(PieceLetters, c);
+            if (!letter || c == 'K' || c == '\0') {
+                throw std::invalid_argument("некорректная сигнатура " + name);
+            }
+            out.push_back(static_cast<PieceType>(letter - PieceLetters));
+        }
+        std::sort(out.rbegin(), out.rend());
+    };
+    readSide(name.substr(1, separator - 1), material.white);
+    readSide(name.substr(separator + 2), material.black);
+
+    if (material.pieceCount() > TB_MAX_PIECES) {
+        throw std::invalid_argument("слишком много фигур: " + name);
+    }
+    return material;
+}
+
+std::string TbMaterial::name() const
+{
+    std::string result = "K";
+    for (const PieceType type : white) {
+        result += PieceLetters[type];
+    }
+    result += "vK";
+    for (const PieceType type : black) {
+        result += PieceLetters[type];
+    }
+    return result;
+}
+
+bool TbMaterial::hasPawns() const
+{
+    return std::count(white.begin(), white.end(), PT_PAWN) +
+               std::count(black.begin(), black.end(), PT_PAWN) >
+           0;
+}
+
+bool TbMaterial::isCanonical() const
+{
+    // Больше фигур, а при равенстве более ценные - у белых
+    if (white.size() != black.size())
+        return white.size() > black.size();
+    return !std::lexicographical_compare(
+        white.begin(), white.end(), black.begin(), black.end());
+}
+
+size_t Tablebase::entryCount(const TbMaterial &material)
+{
+    const size_t kings =
+        material.hasPawns() ? 32 : static_cast<size_t>(Kings.triangleCount);
+    return 2 * kings * power64(material.pieceCount() - 1);
+}
+
+size_t Tablebase::index(const TbMaterial &material, const TbPosition &position)
+{
+    const bool pawns = material.hasPawns();
+    const int transform = canonicalTransform(position, pawns);
+    const int king = transformSquare(position.square[0], transform);
+
+    size_t result = position.whiteToMove ? 0 : 1;
+    result = result * (pawns ? 32 : Kings.triangleCount) +
+             (pawns ? Kings.half[king] : Kings.triangle[king]);
+    for (int i = 1; i < position.count; ++i) {
+        result = result * 64 + transformSquare(position.square[i], transform);
+    }
+    return result;
+}
+
+bool Tablebase::decode(const TbMaterial &material,
+                       size_t index,
+                       TbPosition &position)
+{
+    const bool pawns = material.hasPawns();
+    position.count = material.pieceCount();
+    for (int i = position.count - 1; i >= 1; --i) {
+        position.square[i] = static_cast<int>(index % 64);
+        index /= 64;
+    }
+
+    const int kings = pawns ? 32 : Kings.triangleCount;
+    const int king = static_cast<int>(index % kings);
+    index /= kings;
+    position.whiteToMove = index == 0;
+
+    position.square[0] = -1;
+    for (int sq = 0; sq < 64; ++sq) {
+        if ((pawns ? Kings.half[sq] : Kings.triangle[sq]) == king) {
+            position.square[0] = sq;
+            break;
+        }
+    }
+
+    position.type[0] = position.type[1] = PT_KING;
+    position.color[0] = WHITE;
+    position.color[1] = BLACK;
+    int i = 2;
+    for (const PieceType type : material.white) {
+        position.type[i] = type;
+        position.color[i++] = WHITE;
+    }
+    for (const PieceType type : material.black) {
+        position.type[i] = type;
+        position.color[i++] = BLACK;
+    }
+    return position.square[0] >= 0 && index < 2;
+}
+
+Tablebase::Tablebase(const TbMaterial &material,
+                     std::vector<uint64_t> packed,
+                     int bits)
+    : material(material), entries(entryCount(material)), bits(bits),
+      owned(std::move(packed))
+{
+    data = owned.data();
+}
+
+Tablebase::Tablebase(const TbMaterial &material,
+                     const uint64_t *data,
+                     int bits,
+                     void *mapping,
+                     size_t mappedBytes)
+    : material(material), entries(entryCount(material)), bits(bits), data(data),
+      mapping(mapping), mappedBytes(mappedBytes)
+{
+}
+
+Tablebase::~Tablebase()
+{
+    if (mapping) {
+        munmap(mapping, mappedBytes);
+    }
+}
+
+TbResult Tablebase::probe(const TbPosition &position) const
+{
+    const size_t bit = index(material, position) * bits;
+    const size_t word = bit / 64;
+    const int shift = static_cast<int>(bit % 64);
+    uint64_t value = data[word] >> shift;
+    if (shift + bits > 64) {
+        value |= data[word + 1] << (64 - shift);
+    }
+    value &= (1ULL << bits) - 1;
+
+    TbResult result;
+    if (value > 0) {
+        result.dtm = static_cast<int>(value) - 1;
+        result.wdl = result.dtm % 2 == 1 ? 1 : -1;
+    }
+    return result;
+}
+
+void writeTablebase(const std::string &path,
+                    const TbMaterial &material,
+                    const std::vector<uint64_t> &packed,
+                    int bits)
+{
+    TbHeader header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    const std::string name = material.name();
+    memcpy(header.name, name.c_str(), std::min(name.size(), sizeof(header.name) - 1));
+    header.entries = Tablebase::entryCount(material);
+    header.bits = static_cast<uint32_t>(bits);
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(packed.data()),
+              packed.size() * sizeof(uint64_t));
+    if (!out) {
+        throw std::runtime_error("не удалось записать " + path);
+    }
+}
+
+int Tablebases::load(const std::string &directory)
+{
+    int loaded = 0;
+    std::error_code error;
+    for (const auto &file : std::filesystem::directory_iterator(directory, error)) {
+        if (file.path().extension() != ".cbtb") {
+            continue;
+        }
+
+        const int fd = ::open(file.path().c_str(), O_RDONLY);
+        if (fd < 0) {
+            continue;
+        }
+        struct stat info;
+        void *mapped = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > static_cast<off_t>(HEADER_SIZE)) {
+            mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            continue;
+        }
+
+        // Файл не того формата или обрезанный пропускаем
+        const auto *header = static_cast<const TbHeader *>(mapped);
+        try {
+            if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+                throw std::invalid_argument("не таблица");
+            }
+            const TbMaterial material = TbMaterial::parse(
+                std::string(header->name, strnlen(header->name, sizeof(header->name))));
+            const size_t words = (header->entries * header->bits + 63) / 64 + 1;
+            if (header->entries != Tablebase::entryCount(material) ||
+                header->bits == 0 || header->bits > 16 ||
+                static_cast<size_t>(info.st_size) < HEADER_SIZE + words * 8) {
+                throw std::invalid_argument("повреждённая таблица");
+            }
+
+            const auto *data = reinterpret_cast<const uint64_t *>(
+                static_cast<const char *>(mapped) + HEADER_SIZE);
+            add(std::make_unique<Tablebase>(
+                material, data, header->bits, mapped, info.st_size));
+            ++loaded;
+        } catch (const std::exception &) {
+            munmap(mapped, info.st_size);
+        }
+    }
+    return loaded;
+}
+
+void Tablebases::add(std::unique_ptr<Tablebase> table)
+{
+    largest = std::max(largest, table->getMaterial().pieceCount());
+    tables[table->getMaterial().name()] = std::move(table);
+}
+
+bool Tablebases::probe(const TbPosition &position, TbResult &result) const
+{
+    if (position.count == 2) {
+        result = TbResult();
+        return true;
+    }
+
+    TbPosition sorted = position;
+    sortPieces(sorted);
+    const TbMaterial material = materialOf(sorted);
+    if (material.isCanonical()) {
+        const auto it = tables.find(material.name());
+        if (it != tables.end()) {
+            result = it->second->probe(sorted);
+            return true;
+        }
+    }
+
+    // Симметричный материал (KRvKR) может найтись и без смены цветов
+    const auto it = tables.find(material.flipped().name());
+    if (it == tables.end()) {
+        return false;
+    }
+    result = it->second->probe(flipColors(sorted));
+    return true;
+}
+
+bool Tablebases::probe(const Board &board, TbResult &result) const
+{
+    TbPosition position;
+    TbMaterial material;
+    return popCount(board.getOccupancy()) <= maxPieces() &&
+           toTbPosition(board, position, material) && probe(position, result);
+}
+
+bool toTbPosition(const Board &board, TbPosition &position, TbMaterial &material)
+{
+    if (popCount(board.getOccupancy()) > TB_MAX_PIECES ||
+        board.getCastlingRights() != 0) {
+        return false;
+    }
+
+    // Таблицы не знают о взятии на проходе: годится только позиция, где
+    // такого взятия на самом деле нет
+    const int epSquare = board.getEpSquare();
+    const Color us = board.isWhiteToMove() ? WHITE : BLACK;
+    const Color them = us == WHITE ? BLACK : WHITE;
+    if (epSquare >= 0 &&
+        (PawnAttacks[them][epSquare] & board.getPieces(us, PT_PAWN))) {
+        return false;
+    }
+
+    position.count = 2;
+    position.whiteToMove = board.isWhiteToMove();
+    for (int color = WHITE; color <= BLACK; ++color) {
+        for (int type = PT_PAWN; type <= PT_KING; ++type) {
+            Bitboard bb = board.getPieces(static_cast<Color>(color),
+                                          static_cast<PieceType>(type));
+            while (bb) {
+                const int sq = popLsb(bb);
+                const int i = type == PT_KING ? color : position.count++;
+                position.square[i] = sq;
+                position.type[i] = static_cast<PieceType>(type);
+                position.color[i] = static_cast<Color>(color);
+            }
+        }
+    }
+    sortPieces(position);
+    material = materialOf(position);
+    return true;
+}
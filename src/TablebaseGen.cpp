@@ -0,0 +1,574 @@
+#include "../include/Tablebase.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Состояние позиции во время построения: неизвестно, невозможная позиция,
+// ничья или VALUE_DTM + dtm (нечётный dtm - выигрыш ходящего)
+constexpr uint16_t VALUE_UNKNOWN = 0;
+constexpr uint16_t VALUE_INVALID = 1;
+constexpr uint16_t VALUE_DRAW = 2;
+constexpr uint16_t VALUE_DTM = 3;
+
+// Выигрыш, найденный через взятие или превращение, ставится в очередь
+// заранее и засчитывается, только если до его уровня позиция не решилась
+constexpr uint32_t CANDIDATE = 1u << 31;
+
+Bitboard occupancy(const TbPosition &position)
+{
+    Bitboard occupied = 0;
+    for (int i = 0; i < position.count; ++i) {
+        occupied |= squareBB(position.square[i]);
+    }
+    return occupied;
+}
+
+Bitboard pieceAttacks(PieceType type, Color color, int sq, Bitboard occupied)
+{
+    switch (type) {
+    case PT_PAWN:
+        return PawnAttacks[color][sq];
+    case PT_KNIGHT:
+        return KnightAttacks[sq];
+    case PT_BISHOP:
+        return bishopAttacks(sq, occupied);
+    case PT_ROOK:
+        return rookAttacks(sq, occupied);
+    case PT_QUEEN:
+        return queenAttacks(sq, occupied);
+    default:
+        return KingAttacks[sq];
+    }
+}
+
+bool isAttacked(const TbPosition &position, int sq, Color by, Bitboard occupied)
+{
+    for (int i = 0; i < position.count; ++i) {
+        if (position.color[i] == by &&
+            (pieceAttacks(position.type[i], by, position.square[i], occupied) &
+             squareBB(sq))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool inCheck(const TbPosition &position, Color side)
+{
+    return isAttacked(position,
+                      position.square[side == WHITE ? 0 : 1],
+                      side == WHITE ? BLACK : WHITE,
+                      occupancy(position));
+}
+
+// Позиция возможна: фигуры на разных полях, пешки не на крайних
+// горизонталях, король стороны, которая не ходит, не под шахом
+bool isValid(const TbPosition &position)
+{
+    Bitboard occupied = 0;
+    for (int i = 0; i < position.count; ++i) {
+        const int sq = position.square[i];
+        if (occupied & squareBB(sq))
+            return false;
+        if (position.type[i] == PT_PAWN && (squareX(sq) == 0 || squareX(sq) == 7))
+            return false;
+        occupied |= squareBB(sq);
+    }
+    return !inCheck(position, position.whiteToMove ? BLACK : WHITE);
+}
+
+void removePiece(TbPosition &position, int i)
+{
+    const int last = position.count - 1;
+    position.square[i] = position.square[last];
+    position.type[i] = position.type[last];
+    position.color[i] = position.color[last];
+    --position.count;
+}
+
+// Перебирает легальные ходы: visit(child, leavesTable) возвращает false,
+// чтобы прервать перебор. Взятия и превращения уводят в другую таблицу
+template <typename Visit>
+int forEachMove(const TbPosition &position, Visit &&visit)
+{
+    const Color us = position.whiteToMove ? WHITE : BLACK;
+    const Bitboard occupied = occupancy(position);
+    Bitboard own = 0;
+    for (int i = 0; i < position.count; ++i) {
+        if (position.color[i] == us)
+            own |= squareBB(position.square[i]);
+    }
+
+    int legal = 0;
+    for (int i = 0; i < position.count; ++i) {
+        if (position.color[i] != us)
+            continue;
+
+        const int from = position.square[i];
+        Bitboard targets;
+        if (position.type[i] == PT_PAWN) {
+            const int forward = us == WHITE ? -8 : 8;
+            targets = PawnAttacks[us][from] & occupied & ~own;
+            if (!(occupied & squareBB(from + forward))) {
+                targets |= squareBB(from + forward);
+                const int startRow = us == WHITE ? 6 : 1;
+                if (squareX(from) == startRow &&
+                    !(occupied & squareBB(from + 2 * forward)))
+                    targets |= squareBB(from + 2 * forward);
+            }
+        } else {
+            targets = pieceAttacks(position.type[i], us, from, occupied) & ~own;
+        }
+
+        while (targets) {
+            const int to = popLsb(targets);
+            TbPosition child = position;
+            child.square[i] = to;
+            child.whiteToMove = !position.whiteToMove;
+
+            bool leavesTable = false;
+            for (int j = 2; j < child.count; ++j) {
+                if (j != i && child.square[j] == to) {
+                    removePiece(child, j);
+                    leavesTable = true;
+                    break;
+                }
+            }
+            if (inCheck(child, us))
+                continue;
+
+            const bool promotion = position.type[i] == PT_PAWN &&
+                                   (squareX(to) == 0 || squareX(to) == 7);
+            if (!promotion) {
+                ++legal;
+                if (!visit(child, leavesTable))
+                    return legal;
+                continue;
+            }
+
+            // После удаления взятой фигуры пешка могла сменить номер
+            int pawn = 2;
+            while (child.square[pawn] != to) {
+                ++pawn;
+            }
+            for (const PieceType type : {PT_QUEEN, PT_ROOK, PT_BISHOP, PT_KNIGHT}) {
+                child.type[pawn] = type;
+                ++legal;
+                if (!visit(child, true))
+                    return legal;
+            }
+        }
+    }
+    return legal;
+}
+
+// Обратные ходы: позиции, из которых сторона, только что сходившая,
+// могла прийти сюда тихим ходом. Взятия и превращения назад не ведут
+template <typename Visit>
+void forEachUnmove(const TbPosition &position, Visit &&visit)
+{
+    const Color them = position.whiteToMove ? BLACK : WHITE;
+    const Color us = position.whiteToMove ? WHITE : BLACK;
+    const Bitboard occupied = occupancy(position);
+
+    for (int i = 0; i < position.count; ++i) {
+        if (position.color[i] != them)
+            continue;
+
+        const int to = position.square[i];
+        Bitboard sources;
+        if (position.type[i] == PT_PAWN) {
+            const int back = them == WHITE ? 8 : -8;
+            const int row = squareX(to);
+            sources = 0;
+            const int single = to + back;
+            const bool singleOk = them == WHITE ? row + 1 <= 6 : row - 1 >= 1;
+            if (singleOk && !(occupied & squareBB(single))) {
+                sources |= squareBB(single);
+                const int fourthRow = them == WHITE ? 4 : 3;
+                if (row == fourthRow && !(occupied & squareBB(single + back)))
+                    sources |= squareBB(single + back);
+            }
+        } else {
+            sources = pieceAttacks(position.type[i], them, to, occupied) & ~occupied;
+        }
+
+        while (sources) {
+            TbPosition previous = position;
+            previous.square[i] = popLsb(sources);
+            previous.whiteToMove = !position.whiteToMove;
+            // В позиции до хода король стороны, которая не ходит, не под шахом
+            if (!inCheck(previous, us))
+                visit(previous);
+        }
+    }
+}
+
+class Generator {
+public:
+    Generator(const TbMaterial &material, const Tablebases &known, int threads)
+        : material(material), known(known), threads(std::max(threads, 1)),
+          entries(Tablebase::entryCount(material)),
+          values(new std::atomic<uint16_t>[entries])
+    {
+    }
+
+    std::unique_ptr<Tablebase> run(std::vector<uint64_t> &packed, int &bits);
+
+private:
+    using Pushes = std::vector<std::pair<int, uint32_t>>;
+
+    TbMaterial material;
+    const Tablebases &known;
+    int threads;
+    size_t entries;
+    std::unique_ptr<std::atomic<uint16_t>[]> values;
+    std::vector<std::vector<uint32_t>> levels;
+
+    // Значение ребёнка со стороны ходящего в нём
+    bool childValue(const TbPosition &child, bool leavesTable, TbResult &result) const;
+    void initialize(size_t begin, size_t end, Pushes &pushes);
+    void process(uint32_t entry, int level, Pushes &pushes);
+    bool proveLoss(const TbPosition &position, int &dtm) const;
+    bool resolve(size_t index, int dtm);
+    void parallel(size_t count, const std::function<void(size_t, size_t, Pushes &)> &work);
+};
+
+bool Generator::childValue(const TbPosition &child,
+                           bool leavesTable,
+                           TbResult &result) const
+{
+    if (leavesTable) {
+        if (!known.probe(child, result)) {
+            throw std::runtime_error("не построена таблица для " +
+                                     material.name() + " после размена");
+        }
+        return true;
+    }
+
+    const uint16_t value = values[Tablebase::index(material, child)];
+    if (value < VALUE_DTM)
+        return false;
+    result.dtm = value - VALUE_DTM;
+    result.wdl = result.dtm % 2 == 1 ? 1 : -1;
+    return true;
+}
+
+bool Generator::resolve(size_t index, int dtm)
+{
+    uint16_t expected = VALUE_UNKNOWN;
+    return values[index].compare_exchange_strong(
+        expected, static_cast<uint16_t>(VALUE_DTM + dtm));
+}
+
+void Generator::initialize(size_t begin, size_t end, Pushes &pushes)
+{
+    for (size_t index = begin; index < end; ++index) {
+        TbPosition position;
+        if (!Tablebase::decode(material, index, position) || !isValid(position) ||
+            Tablebase::index(material, position) != index) {
+            values[index] = VALUE_INVALID;
+            continue;
+        }
+        values[index] = VALUE_UNKNOWN;
+
+        // Ходы, уводящие в уже построенные таблицы, оцениваем сразу
+        int quietMoves = 0;
+        int bestWin = -1;
+        int longestLoss = 0;
+        bool escape = false;
+        const int legal = forEachMove(position, [&](const TbPosition &child, bool leaves) {
+            if (!leaves) {
+                ++quietMoves;
+                return true;
+            }
+            TbResult result;
+            childValue(child, true, result);
+            if (result.wdl < 0) {
+                if (bestWin < 0 || result.dtm + 1 < bestWin)
+                    bestWin = result.dtm + 1;
+            } else if (result.wdl > 0) {
+                longestLoss = std::max(longestLoss, result.dtm + 1);
+            } else {
+                escape = true;
+            }
+            return true;
+        });
+
+        const Color us = position.whiteToMove ? WHITE : BLACK;
+        if (legal == 0) {
+            if (inCheck(position, us)) {
+                values[index] = VALUE_DTM;
+                pushes.push_back({0, static_cast<uint32_t>(index)});
+            } else {
+                values[index] = VALUE_DRAW;
+            }
+        } else if (bestWin > 0) {
+            pushes.push_back({bestWin, static_cast<uint32_t>(index) | CANDIDATE});
+        } else if (quietMoves == 0 && !escape) {
+            values[index] = static_cast<uint16_t>(VALUE_DTM + longestLoss);
+            pushes.push_back({longestLoss, static_cast<uint32_t>(index)});
+        }
+    }
+}
+
+bool Generator::proveLoss(const TbPosition &position, int &dtm) const
+{
+    // Проигрыш, только если каждый ход ведёт к выигрышу соперника
+    bool lost = true;
+    dtm = 0;
+    forEachMove(position, [&](const TbPosition &child, bool leaves) {
+        TbResult result;
+        if (!childValue(child, leaves, result) || result.wdl <= 0) {
+            lost = false;
+            return false;
+        }
+        dtm = std::max(dtm, result.dtm + 1);
+        return true;
+    });
+    return lost;
+}
+
+void Generator::process(uint32_t entry, int level, Pushes &pushes)
+{
+    const size_t index = entry & ~CANDIDATE;
+    if ((entry & CANDIDATE) && !resolve(index, level))
+        return;
+
+    TbPosition position;
+    Tablebase::decode(material, index, position);
+
+    forEachUnmove(position, [&](const TbPosition &previous) {
+        const size_t previousIndex = Tablebase::index(material, previous);
+        if (values[previousIndex] != VALUE_UNKNOWN)
+            return;
+
+        // Из проигранной позиции предшественник выигрывает ходом сюда,
+        // а выигранная лишь убирает у предшественника ещё один выход
+        if (level % 2 == 0) {
+            if (resolve(previousIndex, level + 1))
+                pushes.push_back({level + 1, static_cast<uint32_t>(previousIndex)});
+            return;
+        }
+        int dtm;
+        if (proveLoss(previous, dtm) && resolve(previousIndex, dtm))
+            pushes.push_back({dtm, static_cast<uint32_t>(previousIndex)});
+    });
+}
+
+void Generator::parallel(size_t count,
+                         const std::function<void(size_t, size_t, Pushes &)> &work)
+{
+    // Работа режется на куски, которые потоки разбирают через общий счётчик
+    const size_t chunk = std::max<size_t>(1024, count / (threads * 16) + 1);
+    std::atomic<size_t> next{0};
+    std::vector<Pushes> pushes(threads);
+    std::vector<std::thread> pool;
+
+    auto worker = [&](int id) {
+        for (size_t begin = next.fetch_add(chunk); begin < count;
+             begin = next.fetch_add(chunk)) {
+            work(begin, std::min(begin + chunk, count), pushes[id]);
+        }
+    };
+    for (int i = 1; i < threads; ++i) {
+        pool.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+
+    for (const Pushes &local : pushes) {
+        for (const auto &[level, entry] : local) {
+            if (static_cast<size_t>(level) >= levels.size())
+                levels.resize(level + 1);
+            levels[level].push_back(entry);
+        }
+    }
+}
+
+std::unique_ptr<Tablebase> Generator::run(std::vector<uint64_t> &packed, int &bits)
+{
+    parallel(entries, [this](size_t begin, size_t end, Pushes &pushes) {
+        initialize(begin, end, pushes);
+    });
+
+    // Уровни идут по возрастанию dtm, поэтому первое найденное значение
+    // позиции и есть кратчайший выигрыш или самый долгий проигрыш
+    for (size_t level = 0; level < levels.size(); ++level) {
+        const std::vector<uint32_t> current = std::move(levels[level]);
+        parallel(current.size(),
+                 [this, &current, level](size_t begin, size_t end, Pushes &pushes) {
+                     for (size_t i = begin; i < end; ++i) {
+                         process(current[i], static_cast<int>(level), pushes);
+                     }
+                 });
+    }
+
+    // Всё, что не решилось, - ничья. В файле 0 - ничья, иначе dtm + 1
+    int maxValue = 0;
+    for (size_t i = 0; i < entries; ++i) {
+        if (values[i] >= VALUE_DTM)
+            maxValue = std::max(maxValue, values[i] - VALUE_DTM + 1);
+    }
+    bits = 1;
+    while ((1 << bits) <= maxValue) {
+        ++bits;
+    }
+
+    packed.assign((entries * bits + 63) / 64 + 1, 0);
+    for (size_t i = 0; i < entries; ++i) {
+        const uint64_t value =
+            values[i] >= VALUE_DTM ? values[i] - VALUE_DTM + 1 : 0;
+        const size_t bit = i * bits;
+        packed[bit / 64] |= value << (bit % 64);
+        if (bit % 64 + bits > 64)
+            packed[bit / 64 + 1] |= value >> (64 - bit % 64);
+    }
+    return std::make_unique<Tablebase>(material, packed, bits);
+}
+
+// Таблицы, в которые ведут взятия и превращения
+std::vector<TbMaterial> dependencies(const TbMaterial &material)
+{
+    std::vector<TbMaterial> result;
+    auto addCanonical = [&](TbMaterial sub) {
+        if (sub.pieceCount() <= 2)
+            return;
+        std::sort(sub.white.rbegin(), sub.white.rend());
+        std::sort(sub.black.rbegin(), sub.black.rend());
+        result.push_back(sub.isCanonical() ? sub : sub.flipped());
+    };
+
+    for (int side = 0; side < 2; ++side) {
+        const std::vector<PieceType> &pieces = side == 0 ? material.white : material.black;
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            TbMaterial captured = material;
+            auto &list = side == 0 ? captured.white : captured.black;
+            list.erase(list.begin() + i);
+            addCanonical(captured);
+
+            if (pieces[i] == PT_PAWN) {
+                for (const PieceType type : {PT_QUEEN, PT_ROOK, PT_BISHOP, PT_KNIGHT}) {
+                    TbMaterial promoted = material;
+                    (side == 0 ? promoted.white : promoted.black)[i] = type;
+                    addCanonical(promoted);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> allSignatures()
+{
+    const std::string pieces = "QRBNP";
+    std::set<std::string> names;
+    for (const char a : pieces) {
+        names.insert(std::string("K") + a + "vK");
+        for (const char b : pieces) {
+            std::vector<std::string> candidates = {std::string("K") + a + b + "vK",
+                                                   std::string("K") + a + "vK" + b};
+            for (const std::string &name : candidates) {
+                TbMaterial material = TbMaterial::parse(name);
+                if (!material.isCanonical())
+                    material = material.flipped();
+                if (!(std::count(material.white.begin(), material.white.end(), PT_PAWN) &&
+                      std::count(material.black.begin(), material.black.end(), PT_PAWN)))
+                    names.insert(material.name());
+            }
+        }
+    }
+    return {names.begin(), names.end()};
+}
+
+void generate(const TbMaterial &material,
+              Tablebases &tables,
+              const std::string &directory,
+              int threads)
+{
+    if (tables.contains(material.name()))
+        return;
+
+    // Взятие на проходе в таблицах не учитывается, поэтому пешки
+    // допустимы только у одной стороны
+    if (std::count(material.white.begin(), material.white.end(), PT_PAWN) &&
+        std::count(material.black.begin(), material.black.end(), PT_PAWN)) {
+        throw std::invalid_argument(material.name() +
+                                    ": пешки у обеих сторон не поддерживаются");
+    }
+
+    for (const TbMaterial &sub : dependencies(material)) {
+        generate(sub, tables, directory, threads);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    Generator generator(material, tables, threads);
+    std::vector<uint64_t> packed;
+    int bits = 0;
+    std::unique_ptr<Tablebase> table = generator.run(packed, bits);
+
+    const std::string path = directory + "/" + material.name() + ".cbtb";
+    writeTablebase(path, material, packed, bits);
+
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+    std::cout << material.name() << ": " << table->size() << " позиций, "
+              << bits << " бит на позицию, " << seconds << " с\n";
+
+    tables.add(std::move(table));
+}
+
+} // namespace
+
+int tbgenCommand(int argc, char *argv[])
+{
+    // chessbot tbgen <dir> [--threads <N>] <сигнатура>... | all
+    std::string directory;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> names;
+    try {
+        if (argc < 4) {
+            throw std::invalid_argument("не указаны каталог и таблицы");
+        }
+        directory = argv[2];
+        initBitboards();
+        for (int i = 3; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                threads = std::stoi(argv[++i]);
+            } else if (arg == "all") {
+                const std::vector<std::string> all = allSignatures();
+                names.insert(names.end(), all.begin(), all.end());
+            } else {
+                names.push_back(arg);
+            }
+        }
+
+        // Уже построенные таблицы из каталога берём как есть
+        Tablebases tables;
+        tables.load(directory);
+        for (const std::string &name : names) {
+            TbMaterial material = TbMaterial::parse(name);
+            if (!material.isCanonical())
+                material = material.flipped();
+            generate(material, tables, directory, threads);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Ошибка: " << e.what() << "\n"
+                  << "Использование: chessbot tbgen <dir> [--threads <N>] "
+                     "<KQvK|KRvK|...>... | all\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "../include/TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    // Число корзин - наибольшая степень двойки, влезающая в заданный объём
+    const size_t bytes = (megabytes ? megabytes : 1) * 1024 * 1024;
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= bytes) {
+        count *= 2;
+    }
+
+    buckets = std::make_unique<Bucket[]>(count);
+    bucketCount = count;
+    mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < bucketCount; ++i) {
+        for (Slot &slot : buckets[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+    generation = (generation + 1) & 0x3F;
+}
+
+uint64_t TranspositionTable::pack(const TTEntry &entry)
+{
+    return static_cast<uint32_t>(entry.score) |
+           static_cast<uint64_t>(entry.bestMove.data) << 32 |
+           static_cast<uint64_t>(static_cast<uint8_t>(entry.depth)) << 48 |
+           static_cast<uint64_t>(entry.genBound) << 56;
+}
+
+TTEntry TranspositionTable::unpack(uint64_t key, uint64_t data)
+{
+    TTEntry entry;
+    entry.key = key;
+    entry.score = static_cast<int32_t>(static_cast<uint32_t>(data));
+    entry.bestMove.data = static_cast<uint16_t>(data >> 32);
+    entry.depth = static_cast<int8_t>(data >> 48);
+    entry.genBound = static_cast<uint8_t>(data >> 56);
+    return entry;
+}
+
+int TranspositionTable::age(const TTEntry &entry) const
+{
+    return (generation - entry.generation()) & 0x3F;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry &entry) const
+{
+    const Bucket &bucket = buckets[key & mask];
+    for (const Slot &slot : bucket.slots) {
+        const uint64_t data = slot.data.load(std::memory_order_relaxed);
+        const uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && (data >> 56 & 3) != TT_NONE) {
+            entry = unpack(key, data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key,
+                               int depth,
+                               int score,
+                               TTBound bound,
+                               const Move &bestMove)
+{
+    Bucket &bucket = buckets[key & mask];
+
+    // Своя запись, иначе запись с наименьшей ценностью: мелкая и старая
+    Slot *replace = &bucket.slots[0];
+    TTEntry old = unpack(0, 0);
+    int worst = 0;
+    bool first = true;
+    for (Slot &slot : bucket.slots) {
+        const uint64_t data = slot.data.load(std::memory_order_relaxed);
+        const uint64_t slotKey = slot.check.load(std::memory_order_relaxed) ^ data;
+        const TTEntry candidate = unpack(slotKey, data);
+
+        if (candidate.bound() == TT_NONE || candidate.key == key) {
+            replace = &slot;
+            old = candidate;
+            break;
+        }
+        const int value = candidate.depth - 8 * age(candidate);
+        if (first || value < worst) {
+            replace = &slot;
+            old = candidate;
+            worst = value;
+            first = false;
+        }
+    }
+
+    // Не затираем более глубокий результат той же позиции неточной оценкой
+    if (old.bound() != TT_NONE && old.key == key &&
+        old.generation() == generation && depth < old.depth &&
+        bound != TT_EXACT) {
+        return;
+    }
+
+    TTEntry entry;
+    entry.key = key;
+    entry.score = score;
+    // Лучший ход от прошлого поиска полезнее, чем никакого
+    entry.bestMove =
+        !bestMove.isValid() && old.key == key ? old.bestMove : bestMove;
+    entry.depth = static_cast<int8_t>(depth);
+    entry.genBound = static_cast<uint8_t>(generation << 2 | bound);
+
+    const uint64_t data = pack(entry);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const
+{
+    // Доля занятых записей текущего поиска в промилле по первой тысяче корзин
+    const size_t sample = bucketCount < 1000 ? bucketCount : 1000;
+    size_t used = 0;
+    for (size_t i = 0; i < sample; ++i) {
+        for (const Slot &slot : buckets[i].slots) {
+            const TTEntry entry =
+                unpack(0, slot.data.load(std::memory_order_relaxed));
+            if (entry.bound() != TT_NONE && entry.generation() == generation) {
+                ++used;
+            }
+        }
+    }
+    return static_cast<int>(used * 1000 / (sample * BUCKET_SIZE));
+}
@@ -0,0 +1,328 @@
+#include "../include/Uci.h"
+#include "../include/Board.h"
+#include "../include/Engine.h"
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+const char *START_FEN =
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+class UciSession {
+public:
+    UciSession(std::istream &in, std::ostream &out) : in(in), out(out)
+    {
+        engine.setInfoCallback(
+            [this](const SearchInfo &info) { printInfo(info); });
+    }
+
+    ~UciSession() { stopSearch(); }
+
+    int run();
+
+private:
+    std::istream &in;
+    std::ostream &out;
+    std::mutex outMutex;
+
+    ChessEngine engine;
+    Board board;
+
+    // Поток поиска. bestmove нельзя отправлять, пока идёт ponder или
+    // infinite: дожидаемся ponderhit/stop, даже если поиск уже закончился
+    std::thread searcher;
+    std::mutex stateMutex;
+    std::condition_variable released;
+    bool holdBestMove = false;
+
+    void send(const std::string &line);
+    void printInfo(const SearchInfo &info);
+
+    void position(std::istringstream &args);
+    void go(std::istringstream &args);
+    void setOption(std::istringstream &args);
+    void stopSearch();
+    void ponderHit();
+    void release();
+};
+
+void UciSession::send(const std::string &line)
+{
+    std::lock_guard<std::mutex> lock(outMutex);
+    out << line << std::endl;
+}
+
+void UciSession::printInfo(const SearchInfo &info)
+{
+    std::ostringstream line;
+    line << "info depth " << info.depth;
+    if (!info.pv.empty()) {
+        // Мат в n ходов, а не полуходов; отрицательный - если матуют нас
+        if (std::abs(info.score) >= MATE_BOUND) {
+            const int plies = MATE_SCORE - std::abs(info.score);
+            const int moves = (plies + 1) / 2;
+            line << " score mate " << (info.score > 0 ? moves : -moves);
+        } else {
+            line << " score cp " << info.score;
+        }
+    }
+    const uint64_t nps =
+        info.timeMs > 0 ? info.nodes * 1000 / static_cast<uint64_t>(info.timeMs)
+                        : 0;
+    line << " nodes " << info.nodes << " nps " << nps << " time "
+         << info.timeMs << " hashfull " << info.hashfull;
+    if (!info.pv.empty()) {
+        line << " pv";
+        for (const Move &move : info.pv) {
+            line << ' ' << move.toUci();
+        }
+    }
+    send(line.str());
+}
+
+void UciSession::position(std::istringstream &args)
+{
+    std::string token;
+    args >> token;
+
+    std::string fen;
+    if (token == "startpos") {
+        fen = START_FEN;
+        args >> token;
+    } else if (token == "fen") {
+        while (args >> token && token != "moves") {
+            fen += token + " ";
+        }
+    } else {
+        return;
+    }
+
+    Board next = Board::fromFEN(fen);
+    if (token == "moves") {
+        while (args >> token) {
+            const Move move = next.findLegalMove(
+                Move::fromChessNotation(token.substr(0, 2), token.substr(2)),
+                next.isWhiteToMove());
+            if (!move.isValid()) {
+                throw std::invalid_argument("недопустимый ход " + token);
+            }
+            UndoInfo undo;
+            next.doMove(move, undo);
+        }
+    }
+    board = next;
+}
+
+void UciSession::go(std::istringstream &args)
+{
+    stopSearch();
+
+    SearchLimits limits;
+    int64_t time[2] = {0, 0};
+    int64_t increment[2] = {0, 0};
+    int movesToGo = 0;
+    bool infinite = false;
+
+    std::string token;
+    while (args >> token) {
+        if (token == "wtime")
+            args >> time[WHITE];
+        else if (token == "btime")
+            args >> time[BLACK];
+        else if (token == "winc")
+            args >> increment[WHITE];
+        else if (token == "binc")
+            args >> increment[BLACK];
+        else if (token == "movestogo")
+            args >> movesToGo;
+        else if (token == "movetime")
+            args >> limits.maxTimeMs;
+        else if (token == "depth")
+            args >> limits.maxDepth;
+        else if (token == "nodes")
+            args >> limits.maxNodes;
+        else if (token == "infinite")
+            infinite = true;
+        else if (token == "ponder")
+            limits.ponder = true;
+    }
+
+    // Из оставшегося времени берём долю на ход плюс большую часть
+    // добавки, но не больше половины запаса
+    const Color us = board.isWhiteToMove() ? WHITE : BLACK;
+    if (limits.maxTimeMs == 0 && time[us] > 0) {
+        const int64_t budget =
+            time[us] / (movesToGo > 0 ? movesToGo + 1 : 30) +
+            increment[us] * 3 / 4;
+        limits.maxTimeMs = std::max<int64_t>(
+            1, std::min(budget, time[us] / 2 - 10));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        holdBestMove = infinite || limits.ponder;
+    }
+
+    // Бесконечный поиск без лимитов: pondering снимается только stop
+    if (infinite) {
+        limits.ponder = true;
+    }
+
+    engine.startSearch(board, limits);
+    searcher = std::thread([this] {
+        const SearchResult result = engine.waitSearch();
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            released.wait(lock, [this] { return !holdBestMove; });
+        }
+
+        std::string line = "bestmove " + (result.bestMove.isValid()
+                                              ? result.bestMove.toUci()
+                                              : std::string("0000"));
+        if (result.pv.size() > 1) {
+            line += " ponder " + result.pv[1].toUci();
+        }
+        send(line);
+    });
+}
+
+void UciSession::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        holdBestMove = false;
+    }
+    released.notify_all();
+}
+
+void UciSession::stopSearch()
+{
+    if (!searcher.joinable()) {
+        return;
+    }
+    engine.stop();
+    release();
+    searcher.join();
+}
+
+void UciSession::ponderHit()
+{
+    engine.ponderHit();
+    release();
+}
+
+void UciSession::setOption(std::istringstream &args)
+{
+    // setoption name <имя> value <значение>
+    std::string token, name, value;
+    args >> token;
+    while (args >> token && token != "value") {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    args >> value;
+
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == "book file") {
+        // Путь может содержать пробелы: берём остаток строки целиком
+        std::string rest;
+        std::getline(args, rest);
+        const std::string path = value + rest;
+        if (!engine.setBookFile(path == "<empty>" ? "" : path)) {
+            send("info string не удалось открыть книгу " + path);
+        }
+    } else if (name == "tablebase path") {
+        std::string rest;
+        std::getline(args, rest);
+        const std::string path = value + rest;
+        const int loaded = engine.setTablebasePath(path == "<empty>" ? "" : path);
+        send("info string таблиц эндшпиля загружено: " + std::to_string(loaded));
+    } else if (name == "book random") {
+        engine.setBookRandom(value == "true");
+    } else if (name == "hash") {
+        engine.setHashSize(std::stoul(value));
+    } else if (name == "threads") {
+        engine.setThreads(std::stoi(value));
+    } else if (name == "clear hash") {
+        engine.clearHash();
+    }
+}
+
+int UciSession::run()
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream args(line);
+        std::string command;
+        args >> command;
+
+        try {
+            if (command == "uci") {
+                send("id name chessbot");
+                send("id author danya-ermilov");
+                send("option name Hash type spin default 16 min 1 max 65536");
+                send("option name Threads type spin default 1 min 1 max 256");
+                send("option name Clear Hash type button");
+                send("option name Book File type string default <empty>");
+                send("option name Book Random type check default true");
+                send("option name Tablebase Path type string default <empty>");
+                send("option name Ponder type check default false");
+                send("uciok");
+            } else if (command == "isready") {
+                send("readyok");
+            } else if (command == "ucinewgame") {
+                stopSearch();
+                engine.clearHash();
+            } else if (command == "setoption") {
+                stopSearch();
+                setOption(args);
+            } else if (command == "position") {
+                stopSearch();
+                position(args);
+            } else if (command == "go") {
+                go(args);
+            } else if (command == "stop") {
+                stopSearch();
+            } else if (command == "ponderhit") {
+                ponderHit();
+            } else if (command == "stats") {
+                // Нестандартная команда: статистика последнего поиска.
+                // Идущий поиск останавливается, как и перед position
+                stopSearch();
+                std::string format;
+                args >> format;
+                std::ostringstream text;
+                if (format == "json")
+                    engine.getStats().printJson(text);
+                else
+                    engine.getStats().printText(text);
+                std::string statsLine;
+                std::istringstream lines(text.str());
+                while (std::getline(lines, statsLine)) {
+                    send("info string " + statsLine);
+                }
+            } else if (command == "quit") {
+                break;
+            }
+        } catch (const std::exception &e) {
+            send(std::string("info string error: ") + e.what());
+        }
+    }
+
+    stopSearch();
+    return 0;
+}
+
+} // namespace
+
+int uciLoop(std::istream &in, std::ostream &out)
+{
+    UciSession session(in, out);
+    return session.run();
+}
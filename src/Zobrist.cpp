@@ -0,0 +1,42 @@
+#include "../include/Zobrist.h"
+#include <mutex>
+
+ZobristKeys Zobrist;
+
+namespace {
+
+void buildZobrist()
+{
+    // Фиксированное зерно: ключи одинаковы от запуска к запуску
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    auto next = [&state]() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    };
+
+    for (auto &color : Zobrist.pieces) {
+        for (auto &type : color) {
+            for (uint64_t &key : type) {
+                key = next();
+            }
+        }
+    }
+    for (uint64_t &key : Zobrist.castling) {
+        key = next();
+    }
+    for (uint64_t &key : Zobrist.epFile) {
+        key = next();
+    }
+    Zobrist.side = next();
+}
+
+} // namespace
+
+void initZobrist()
+{
+    // Первыми ключи могут запросить сразу несколько потоков
+    static std::once_flag once;
+    std::call_once(once, buildZobrist);
+}
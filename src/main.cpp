@@ -1,12 +1,60 @@
 #include "../include/Board.h"
+#include "../include/Book.h"
 #include "../include/Engine.h"
+#include "../include/Epd.h"
+#include "../include/Match.h"
+#include "../include/Perft.h"
+#include "../include/Tablebase.h"
+#include "../include/Uci.h"
+#include <algorithm>
 #include <cctype>
 #include <iostream>
+#include <string>
+#include <thread>
 
-int main()
+int main(int argc, char *argv[])
 {
+    if (argc > 1 && std::string(argv[1]) == "perft") {
+        return perftCommand(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "epd") {
+        return epdCommand(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "book") {
+        return bookCommand(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "match") {
+        return matchCommand(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "tbgen") {
+        return tbgenCommand(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "uci") {
+        return uciLoop(std::cin, std::cout);
+    }
+
     Board board;
     ChessEngine engine;
+    engine.setThreads(std::max(1u, std::thread::hardware_concurrency()));
+
+    // chessbot [--book <book.bin>] [--tb <каталог>]: дебют играется по
+    // книге, окончания с таблицами - без ошибок
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string flag = argv[i];
+        if (flag == "--book" && !engine.setBookFile(argv[i + 1])) {
+            std::cout << "Не удалось открыть книгу " << argv[i + 1] << "\n";
+            return 1;
+        }
+        if (flag == "--tb" && engine.setTablebasePath(argv[i + 1]) == 0) {
+            std::cout << "В каталоге " << argv[i + 1]
+                      << " нет таблиц эндшпиля\n";
+            return 1;
+        }
+    }
+
+    // Бот думает не дольше двух секунд на ход
+    SearchLimits limits;
+    limits.maxTimeMs = 2000;
 
     char choice;
     bool userIsWhite = true;
@@ -23,6 +71,8 @@ int main()
 
     userIsWhite = (choice == 'w');
     bool isWhiteTurn = true;
+    bool pondering = false;
+    Move expectedReply;
 
     std::cout << "Вы играете за " << (userIsWhite ? "белых" : "чёрных")
               << "\n\n";
@@ -30,57 +80,63 @@ int main()
     while (true) {
         board.print();
 
-        if (board.isCheckmate(isWhiteTurn)) {
+        const NodeStatus status = board.nodeStatus(isWhiteTurn);
+        if (status.isCheckmate()) {
             std::cout << (!isWhiteTurn ? "Белые" : "Чёрные") << " победили!\n";
             break;
         }
 
-        if (board.isStalemate(isWhiteTurn)) {
+        if (status.isStalemate()) {
             std::cout << "Пат! Ничья.\n";
             break;
         }
 
         try {
-            if (isWhiteTurn) {
-                if (userIsWhite) {
-                    std::cout << "Ваш ход: ";
-                    std::string from, to;
-                    std::cin >> from >> to;
-
-                    Move move = Move::fromChessNotation(from, to);
-                    if (board.isValidMove(move, isWhiteTurn)) {
-                        board.makeMove(move);
-                        isWhiteTurn = !isWhiteTurn;
-                    } else {
-                        std::cout << "Недопустимый ход! Попробуйте снова.\n";
+            if (isWhiteTurn == userIsWhite) {
+                std::cout << "Ваш ход: ";
+                std::string from, to;
+                std::cin >> from >> to;
+
+                Move move = Move::fromChessNotation(from, to);
+                if (board.isValidMove(move, isWhiteTurn)) {
+                    const Move played = board.findLegalMove(move, isWhiteTurn);
+                    board.makeMove(move);
+                    isWhiteTurn = !isWhiteTurn;
+
+                    // Угадали ход - поиск продолжается уже в своё время,
+                    // нет - останавливаем его, таблица остаётся прогретой
+                    if (pondering && played == expectedReply) {
+                        engine.ponderHit();
+                    } else if (pondering) {
+                        engine.stop();
+                        engine.waitSearch();
+                        pondering = false;
                     }
                 } else {
-                    Move botMove = engine.findBestMove(board, true, 4);
-                    if (board.makeMove(botMove)) {
-                        std::cout << "Ход бота: " << botMove.toChessNotation()
-                                  << "\n";
-                        isWhiteTurn = !isWhiteTurn;
-                    }
+                    std::cout << "Недопустимый ход! Попробуйте снова.\n";
                 }
             } else {
-                if (!userIsWhite) {
-                    std::cout << "Ваш ход: ";
-                    std::string from, to;
-                    std::cin >> from >> to;
-
-                    Move move = Move::fromChessNotation(from, to);
-                    if (board.isValidMove(move, isWhiteTurn)) {
-                        board.makeMove(move);
-                        isWhiteTurn = !isWhiteTurn;
-                    } else {
-                        std::cout << "Недопустимый ход! Попробуйте снова.\n";
-                    }
-                } else {
-                    Move botMove = engine.findBestMove(board, false, 4);
-                    if (board.makeMove(botMove)) {
-                        std::cout << "Ход бота: " << botMove.toChessNotation()
-                                  << "\n";
-                        isWhiteTurn = !isWhiteTurn;
+                const SearchResult result =
+                    pondering ? engine.waitSearch() : engine.search(board, limits);
+                pondering = false;
+
+                if (board.makeMove(result.bestMove)) {
+                    std::cout << "Ход бота: "
+                              << result.bestMove.toChessNotation() << "\n";
+                    isWhiteTurn = !isWhiteTurn;
+
+                    // Пока человек думает, ищем ответ на ожидаемый ход -
+                    // второй ход главного варианта
+                    if (result.pv.size() > 1) {
+                        expectedReply = result.pv[1];
+                        Board ponderBoard = board;
+                        UndoInfo undo;
+                        ponderBoard.doMove(expectedReply, undo);
+
+                        SearchLimits ponderLimits = limits;
+                        ponderLimits.ponder = true;
+                        engine.startSearch(ponderBoard, ponderLimits);
+                        pondering = true;
                     }
                 }
             }